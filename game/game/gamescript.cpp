@@ -394,6 +394,11 @@ void GameScript::initDialogs() {
   vm.enumerate_instances_by_class_name("C_INFO", [this](phoenix::symbol& sym){
     dialogsInfo.push_back(vm.init_instance<phoenix::c_info>(&sym));
     });
+
+  // declaration order is preserved: condition functions may have side effects
+  dialogsByNpc.clear();
+  for(auto& info:dialogsInfo)
+    dialogsByNpc[info->npc].push_back(info.get());
   }
 
 void GameScript::loadDialogOU() {
@@ -474,21 +479,175 @@ void GameScript::loadQuests(Serialize& fin) {
     uint32_t f=0,s=0;
     fin.read(f,s);
     dlgKnownInfos.insert(std::make_pair(f,s));
+    markInfoKnown(f,s);
     }
 
   fin.read(gilAttitudes);
   }
 
+static bool isSavedVar(const phoenix::symbol& s) {
+  return s.count()>0 && !s.is_member() && !s.is_const();
+  }
+
 void GameScript::saveVar(Serialize &fout) {
+  // values are written as contiguous blocks, grouped by type; names are stored separately
+  // and only used, if script was changed since the save
   auto& dat = vm.symbols();
-  fout.write(uint32_t(dat.size()));
-  for(unsigned i = 0; i < dat.size(); ++i){
-    auto* sym = vm.find_symbol_by_index(i); // never returns nullptr
-    saveSym(fout,*sym);
+
+  std::vector<uint32_t>    intSym, fltSym, strSym, instSym;
+  std::vector<int32_t>     intVal;
+  std::vector<float>       fltVal;
+  std::vector<std::string> strVal;
+  std::vector<uint8_t>     instCls;
+  std::vector<uint32_t>    instId, instItm;
+
+  for(uint32_t i=0; i<dat.size(); ++i) {
+    auto& sym = *vm.find_symbol_by_index(i); // never returns nullptr
+    switch(sym.type()) {
+      case phoenix::datatype::integer:
+        if(!isSavedVar(sym))
+          break;
+        intSym.push_back(i);
+        for(unsigned j=0; j<sym.count(); ++j)
+          intVal.push_back(sym.get_int(j));
+        break;
+      case phoenix::datatype::float_:
+        if(!isSavedVar(sym))
+          break;
+        fltSym.push_back(i);
+        for(unsigned j=0; j<sym.count(); ++j)
+          fltVal.push_back(sym.get_float(j));
+        break;
+      case phoenix::datatype::string:
+        if(!isSavedVar(sym))
+          break;
+        strSym.push_back(i);
+        for(unsigned j=0; j<sym.count(); ++j)
+          strVal.push_back(sym.get_string(j));
+        break;
+      case phoenix::datatype::instance: {
+        uint32_t id = 0, itm = 0;
+        uint8_t  cls = saveInstanceVar(sym,id,itm);
+        if(cls==0)
+          break;
+        instSym.push_back(i);
+        instCls.push_back(cls);
+        instId .push_back(id);
+        instItm.push_back(itm);
+        break;
+        }
+      default:
+        break;
+      }
     }
+
+  fout.write(scriptChecksum(),uint32_t(dat.size()));
+  fout.write(intSym,intVal,fltSym,fltVal,strSym,strVal);
+  fout.write(instSym,instCls,instId,instItm);
+
+  std::vector<std::string> names;
+  std::vector<uint32_t>    count;
+  for(auto arr:{&intSym,&fltSym,&strSym,&instSym})
+    for(auto i:*arr) {
+      auto& sym = *vm.find_symbol_by_index(i);
+      names.push_back(sym.name());
+      count.push_back(sym.count());
+      }
+  // symbol table goes last: only read back, if script has changed
+  fout.write(names,count);
   }
 
 void GameScript::loadVar(Serialize &fin) {
+  if(fin.globalVersion()<43) {
+    loadVarLegacy(fin);
+    return;
+    }
+
+  uint64_t                 hash = 0;
+  uint32_t                 symCount = 0;
+  std::vector<uint32_t>    intSym, fltSym, strSym, instSym;
+  std::vector<int32_t>     intVal;
+  std::vector<float>       fltVal;
+  std::vector<std::string> strVal;
+  std::vector<uint8_t>     instCls;
+  std::vector<uint32_t>    instId, instItm;
+
+  fin.read(hash,symCount);
+  fin.read(intSym,intVal,fltSym,fltVal,strSym,strVal);
+  fin.read(instSym,instCls,instId,instItm);
+
+  const size_t             total = intSym.size()+fltSym.size()+strSym.size()+instSym.size();
+  std::vector<phoenix::symbol*> sym(total,nullptr);
+  std::vector<uint32_t>    count(total,0);
+
+  if(hash==scriptChecksum() && symCount==vm.symbols().size()) {
+    // same script: map by symbol index
+    size_t r = 0;
+    for(auto arr:{&intSym,&fltSym,&strSym,&instSym})
+      for(auto i:*arr) {
+        sym  [r] = vm.find_symbol_by_index(i);
+        count[r] = sym[r]==nullptr ? 0 : sym[r]->count();
+        ++r;
+        }
+    } else {
+    std::vector<std::string> names;
+    fin.read(names,count);
+    if(names.size()!=total || count.size()!=total)
+      throw std::runtime_error("invalid script variables table");
+    for(size_t r=0; r<total; ++r)
+      sym[r] = findSymbol(names[r]);
+    }
+
+  auto valCount = [&count](size_t b, size_t e) {
+    size_t n = 0;
+    for(size_t i=b; i<e; ++i)
+      n += count[i];
+    return n;
+    };
+  const size_t fltB = intSym.size(), strB = fltB+fltSym.size(), instB = strB+strSym.size();
+  if(valCount(0,fltB)!=intVal.size() || valCount(fltB,strB)!=fltVal.size() || valCount(strB,instB)!=strVal.size() ||
+     instCls.size()!=instSym.size() || instId.size()!=instSym.size() || instItm.size()!=instSym.size())
+    throw std::runtime_error("invalid script variables table");
+
+  size_t r   = 0;
+  auto   var = [&](phoenix::datatype t) -> phoenix::symbol* {
+    auto* s = sym[r];
+    if(s==nullptr || s->type()!=t || !isSavedVar(*s))
+      return nullptr;
+    return s;
+    };
+
+  size_t at = 0;
+  for(; r<intSym.size(); ++r) {
+    auto* s = var(phoenix::datatype::integer);
+    for(uint32_t j=0; s!=nullptr && j<count[r] && j<s->count(); ++j)
+      s->set_int(intVal[at+j],j);
+    at += count[r];
+    }
+
+  at = 0;
+  for(size_t i=0; i<fltSym.size(); ++i, ++r) {
+    auto* s = var(phoenix::datatype::float_);
+    for(uint32_t j=0; s!=nullptr && j<count[r] && j<s->count(); ++j)
+      s->set_float(fltVal[at+j],j);
+    at += count[r];
+    }
+
+  at = 0;
+  for(size_t i=0; i<strSym.size(); ++i, ++r) {
+    auto* s = var(phoenix::datatype::string);
+    for(uint32_t j=0; s!=nullptr && j<count[r] && j<s->count(); ++j)
+      s->set_string(strVal[at+j],j);
+    at += count[r];
+    }
+
+  for(size_t i=0; i<instSym.size(); ++i, ++r) {
+    if(sym[r]!=nullptr && sym[r]->type()==phoenix::datatype::instance)
+      loadInstanceVar(*sym[r],instCls[i],instId[i],instItm[i]);
+    }
+  }
+
+void GameScript::loadVarLegacy(Serialize &fin) {
   std::string name;
   uint32_t sz=0;
   fin.read(sz);
@@ -594,76 +753,71 @@ const QuestLog& GameScript::questLog() const {
   return quests;
   }
 
-void GameScript::saveSym(Serialize &fout, phoenix::symbol &i) {
+uint8_t GameScript::saveInstanceVar(phoenix::symbol& i, uint32_t& id, uint32_t& itmClass) {
   auto& w = world();
-  switch(i.type()) {
-    case phoenix::datatype::integer:
-      if(i.count()>0 && !i.is_member() && !i.is_const()){
-        fout.write(i.type(), i.name(), i.count());
-
-        for (unsigned j = 0; j < i.count(); ++j)
-          fout.write(i.get_int(j));
-        return;
+  if(i.is_instance_of<phoenix::c_npc>()){
+    auto hnpc = reinterpret_cast<const phoenix::c_npc*>(i.get_instance().get());
+    auto npc  = reinterpret_cast<const Npc*>(hnpc==nullptr ? nullptr : hnpc->user_ptr);
+    id = w.npcId(npc);
+    return 1;
+    }
+  if(i.is_instance_of<phoenix::c_item>()){
+    auto item = reinterpret_cast<const phoenix::c_item*>(i.get_instance().get());
+    id = w.itmId(item);
+    if(id!=uint32_t(-1) || item==nullptr)
+      return 2;
+    for(uint32_t r=0; r<w.npcCount(); ++r) {
+      auto& n = *w.npcById(r);
+      if(n.itemCount(item->symbol_index())>0) {
+        id       = r;
+        itmClass = uint32_t(item->symbol_index());
+        return 3;
         }
-      break;
-    case phoenix::datatype::float_:
-      if(i.count()>0 && !i.is_member() && !i.is_const()){
-        fout.write(i.type(), i.name(), i.count());
+      }
+    return 2;
+    }
+  return 0;
+  }
 
-        for (unsigned j = 0; j < i.count(); ++j)
-          fout.write(i.get_float(j));
-        return;
-        }
-      break;
-    case phoenix::datatype::string:
-      if(i.count()>0 && !i.is_member() && !i.is_const()){
-        fout.write(i.type(), i.name(), i.count());
+void GameScript::loadInstanceVar(phoenix::symbol& s, uint8_t dataClass, uint32_t id, uint32_t itmClass) {
+  if(dataClass==1) {
+    auto npc = world().npcById(id);
+    s.set_instance(npc ? npc->handlePtr() : nullptr);
+    }
+  else if(dataClass==2) {
+    auto itm = world().itmById(id);
+    s.set_instance(itm != nullptr ? itm->handlePtr() : nullptr);
+    }
+  else if(dataClass==3) {
+    if(auto npc = world().npcById(id)) {
+      auto itm = npc->getItem(itmClass);
+      s.set_instance(itm ? itm->handlePtr() : nullptr);
+      }
+    }
+  }
 
-        for (unsigned j = 0; j < i.count(); ++j)
-          fout.write(i.get_string(j));
-        return;
-        }
-      break;
-    case phoenix::datatype::instance:
-      fout.write(i.type());
-
-      if(i.is_instance_of<phoenix::c_npc>()){
-        auto hnpc = reinterpret_cast<const phoenix::c_npc*>(i.get_instance().get());
-        auto npc  = reinterpret_cast<const Npc*>(hnpc==nullptr ? nullptr : hnpc->user_ptr);
-        fout.write(uint8_t(1),i.name(),world().npcId(npc));
-        }
-      else if(i.is_instance_of<phoenix::c_item>()){
-          auto     item = reinterpret_cast<const phoenix::c_item*>(i.get_instance().get());
-          uint32_t id   = w.itmId(item);
-          if(id!=uint32_t(-1) || item==nullptr) {
-              fout.write(uint8_t(2),i.name(),id);
-          } else {
-              uint32_t idNpc = uint32_t(-1);
-              for(uint32_t r=0; r<w.npcCount(); ++r) {
-                  auto& n = *w.npcById(r);
-                  if(n.itemCount(item->symbol_index())>0) {
-                      idNpc = r;
-                      fout.write(uint8_t(3),i.name(),idNpc,uint32_t(item->symbol_index()));
-                      break;
-                  }
-              }
-              if(idNpc==uint32_t(-1))
-                  fout.write(uint8_t(2),i.name(),uint32_t(-1));
-          }
-        }
-      else if(i.is_instance_of<phoenix::c_focus>() ||
-              i.is_instance_of<phoenix::c_gil_values>() ||
-              i.is_instance_of<phoenix::c_info>()) {
-        fout.write(uint8_t(0));
-        }
-      else {
-        fout.write(uint8_t(0));
-        }
-      return;
-    default:
-      break;
+uint64_t GameScript::scriptChecksum() {
+  if(symChecksum!=0)
+    return symChecksum;
+  // FNV-1a over symbol layout
+  uint64_t h   = 14695981039346656037ull;
+  auto     mix = [&h](const void* data, size_t sz) {
+    auto b = reinterpret_cast<const uint8_t*>(data);
+    for(size_t i=0; i<sz; ++i) {
+      h ^= b[i];
+      h *= 1099511628211ull;
+      }
+    };
+  for(uint32_t i=0; i<vm.symbols().size(); ++i) {
+    auto&    sym  = *vm.find_symbol_by_index(i);
+    uint32_t desc[2] = {uint32_t(sym.type()), uint32_t(sym.count())};
+    uint8_t  flg  = uint8_t((sym.is_member() ? 1 : 0) | (sym.is_const() ? 2 : 0));
+    mix(sym.name().data(),sym.name().size());
+    mix(desc,sizeof(desc));
+    mix(&flg,sizeof(flg));
     }
-  fout.write((uint32_t) phoenix::datatype::void_);
+  symChecksum = h;
+  return symChecksum;
   }
 
 void GameScript::fixNpcPosition(Npc& npc, float angle0, float distBias) {
@@ -758,21 +912,19 @@ std::vector<GameScript::DlgChoise> GameScript::dialogChoises(std::shared_ptr<pho
                                                                bool includeImp) {
   ScopeVar self (*vm.global_self(),  hnpc);
   ScopeVar other(*vm.global_other(), player);
-  std::vector<phoenix::c_info*> hDialog;
-  for(auto& info : dialogsInfo) {
-    if(info->npc==static_cast<int>(hnpc->symbol_index())) {
-      hDialog.push_back(info.get());
-      }
-    }
+  auto dlg = dialogsByNpc.find(static_cast<int>(hnpc->symbol_index()));
+  if(dlg==dialogsByNpc.end())
+    return {};
 
-  std::vector<DlgChoise> choise;
+  const std::vector<phoenix::c_info*>& hDialog = dlg->second;
+  std::vector<DlgChoise>               choise;
 
   for(int important=includeImp ? 1 : 0;important>=0;--important){
     for(auto& i:hDialog) {
       const phoenix::c_info& info = *i;
       if(info.important!=important)
         continue;
-      bool npcKnowsInfo = doesNpcKnowInfo(*player,vm.find_symbol_by_instance(info)->index());
+      bool npcKnowsInfo = doesNpcKnowInfo(*player,info.symbol_index());
       if(npcKnowsInfo && !info.permanent)
         continue;
 
@@ -2186,8 +2338,12 @@ bool GameScript::npc_checkinfo(std::shared_ptr<phoenix::c_npc> npcRef, int imp)
   auto& pl   = *(hpl);
   auto& npc  = n->handle();
 
-  for(auto& info:dialogsInfo) {
-    if(info->npc!=int32_t(npc.symbol_index()) || info->important!=imp)
+  auto dlg = dialogsByNpc.find(int32_t(npc.symbol_index()));
+  if(dlg==dialogsByNpc.end())
+    return false;
+
+  for(auto info:dlg->second) {
+    if(info->important!=imp)
       continue;
     bool npcKnowsInfo = doesNpcKnowInfo(pl,info->symbol_index());
     if(npcKnowsInfo && !info->permanent)
@@ -3010,9 +3166,20 @@ void GameScript::sort(std::vector<GameScript::DlgChoise> &dlg) {
 void GameScript::setNpcInfoKnown(const phoenix::c_npc& npc, const phoenix::c_info &info) {
   auto id = std::make_pair(vm.find_symbol_by_instance(npc)->index(),vm.find_symbol_by_instance(info)->index());
   dlgKnownInfos.insert(id);
+  markInfoKnown(id.first,id.second);
+  }
+
+void GameScript::markInfoKnown(size_t npcInstance, size_t infoInstance) {
+  auto& bits = dlgKnownBits[npcInstance];
+  if(bits.size()<=infoInstance)
+    bits.resize(std::max(infoInstance+1,vm.symbols().size()),false);
+  bits[infoInstance] = true;
   }
 
 bool GameScript::doesNpcKnowInfo(const phoenix::c_npc& npc, size_t infoInstance) const {
-  auto id = std::make_pair(vm.find_symbol_by_instance(npc)->index(),infoInstance);
-  return dlgKnownInfos.find(id)!=dlgKnownInfos.end();
+  auto it = dlgKnownBits.find(vm.find_symbol_by_instance(npc)->index());
+  if(it==dlgKnownBits.end())
+    return false;
+  auto& bits = it->second;
+  return infoInstance<bits.size() && bits[infoInstance];
   }
@@ -408,9 +408,13 @@ class GameScript final {
 
     void sort(std::vector<DlgChoise>& dlg);
     void setNpcInfoKnown(const phoenix::c_npc& npc, const phoenix::c_info& info);
+    void markInfoKnown(size_t npcInstance, size_t infoInstance);
     bool doesNpcKnowInfo(const phoenix::c_npc& npc, size_t infoInstance) const;
 
-    void saveSym(Serialize& fout, phoenix::symbol& s);
+    void     loadVarLegacy(Serialize& fin);
+    uint8_t  saveInstanceVar(phoenix::symbol& s, uint32_t& id, uint32_t& itmClass);
+    void     loadInstanceVar(phoenix::symbol& s, uint8_t dataClass, uint32_t id, uint32_t itmClass);
+    uint64_t scriptChecksum();
 
     void onWldInstanceRemoved(const phoenix::instance* obj);
     void makeCurrent(Item* w);
@@ -424,9 +428,12 @@ class GameScript final {
     std::unique_ptr<SpellDefinitions>                           spells;
     std::unique_ptr<SvmDefinitions>                             svm;
     uint64_t                                                    svmBarrier=0;
+    uint64_t                                                    symChecksum=0;
 
     std::set<std::pair<size_t,size_t>>                          dlgKnownInfos;
+    std::unordered_map<size_t,std::vector<bool>>                dlgKnownBits;
     std::vector<std::shared_ptr<phoenix::c_info>>     dialogsInfo;
+    std::unordered_map<int32_t,std::vector<phoenix::c_info*>>   dialogsByNpc;
     phoenix::messages                                           dialogs;
     std::unordered_map<size_t,AiState>                          aiStates;
     std::unique_ptr<AiOuputPipe>                                aiDefaultPipe;
@@ -164,6 +164,15 @@ void GameSession::save(Serialize &fout, std::string_view name, const Pixmap& scr
   hdr.playTime  = ticks;
   hdr.isGothic2 = Gothic::inst().version().game;
 
+  if(Gothic::settingsGetI("GAME","deltaSave")!=0) {
+    // unchanged entries are copied from previous save, without deflate
+    if(saveCache==nullptr)
+      saveCache.reset(new SerializeCache());
+    fout.setCache(saveCache.get());
+    } else {
+    saveCache.reset();
+    }
+
   fout.setEntry("header");
   fout.write(hdr);
   {
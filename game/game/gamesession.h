@@ -15,6 +15,7 @@ class World;
 class WorldView;
 class Npc;
 class Serialize;
+class SerializeCache;
 class GSoundEffect;
 class SoundFx;
 class ParticleFx;
@@ -100,6 +101,7 @@ class GameSession final {
     gtime                          wrldTime;
 
     std::vector<WorldStateStorage> visitedWorlds;
+    std::unique_ptr<SerializeCache> saveCache;
 
     ChWorld                        chWorld;
     bool                           exitSessionFlg=false;
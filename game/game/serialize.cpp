@@ -6,11 +6,21 @@
 #include "world/world.h"
 #include "world/fplock.h"
 #include "world/waypoint.h"
+#include "gothic.h"
 
 #include <Tempest/MemReader>
 #include <Tempest/MemWriter>
 #include <Tempest/Log>
 
+static int deflateLevel(Serialize::Compression c) {
+  switch(c) {
+    case Serialize::Compression::Store:    return MZ_NO_COMPRESSION;
+    case Serialize::Compression::Fast:     return MZ_BEST_SPEED;
+    case Serialize::Compression::Balanced: return MZ_DEFAULT_LEVEL;
+    }
+  return MZ_DEFAULT_LEVEL;
+  }
+
 size_t Serialize::writeFunc(void* pOpaque, uint64_t file_ofs, const void* pBuf, size_t n) {
   auto& self = *reinterpret_cast<Serialize*>(pOpaque);
   file_ofs += mz_zip_get_archive_file_start_offset(&self.impl);
@@ -56,6 +66,9 @@ Serialize::Serialize(Tempest::ODevice& fout) : fout(&fout) {
   impl.m_pIO_opaque       = this;
   impl.m_zip_type         = MZ_ZIP_TYPE_USER;
   mz_zip_writer_init_v2(&impl, 0, 0);
+
+  const int lv = Gothic::settingsGetI("GAME","saveCompression");
+  level = Compression(std::clamp(lv,int(Compression::Store),int(Compression::Balanced)));
   }
 
 Serialize::Serialize(Tempest::IDevice& fin) : fin(&fin) {
@@ -67,10 +80,26 @@ Serialize::Serialize(Tempest::IDevice& fin) : fin(&fin) {
 
 Serialize::~Serialize() {
   closeEntry();
+  flushEntries();
+  if(cache!=nullptr) {
+    // drop entries, that are not part of this archive anymore
+    for(auto i=cache->entries.begin(); i!=cache->entries.end();) {
+      if(i->second.gen!=cache->gen)
+        i = cache->entries.erase(i); else
+        ++i;
+      }
+    }
   mz_zip_writer_finalize_archive(&impl);
   mz_zip_writer_end(&impl);
   }
 
+void Serialize::setCache(SerializeCache* c) {
+  flushEntries();
+  cache = c;
+  if(cache!=nullptr)
+    cache->gen++;
+  }
+
 std::string_view Serialize::worldName() const {
   if(ctx!=nullptr)
     return ctx->name();
@@ -82,13 +111,91 @@ void Serialize::closeEntry() {
     return;
   if(entryBuf.empty())
     return;
-
-  mz_uint level  = entryBuf.size()>256 ? MZ_BEST_COMPRESSION : MZ_NO_COMPRESSION;
-  mz_bool status = mz_zip_writer_add_mem(&impl, entryName.c_str(), entryBuf.data(), entryBuf.size(), level);
+  pushEntry(std::move(entryName),std::move(entryBuf));
   entryBuf .clear();
   entryName.clear();
-  if(!status)
-    throw std::runtime_error("unable to write entry in game archive");
+  }
+
+void Serialize::pushEntry(std::string name, std::vector<uint8_t>&& data) {
+  static const size_t PendingMax = 32*1024*1024;
+
+  auto e  = std::make_unique<PendingEntry>();
+  e->name = std::move(name);
+  e->data = std::move(data);
+  e->size = e->data.size();
+
+  pendingSize += e->size;
+  if(level!=Compression::Store && e->size>256) {
+    const int lv = deflateLevel(level);
+    if(deflate==nullptr)
+      deflate.reset(new Workers::TaskGroup());
+    deflate->run([e=e.get(),lv,cache=cache]() {
+      e->crc = uint32_t(mz_crc32(MZ_CRC32_INIT,e->data.data(),e->data.size()));
+      if(cache!=nullptr) {
+        e->hash   = std::hash<std::string_view>()(std::string_view(reinterpret_cast<const char*>(e->data.data()),e->data.size()));
+        e->hashed = true;
+        auto it = cache->entries.find(e->name);
+        if(it!=cache->entries.end() && it->second.size==e->size && it->second.crc==e->crc && it->second.hash==e->hash) {
+          // unchanged since previous save
+          e->reuse = &it->second;
+          e->data.clear();
+          e->data.shrink_to_fit();
+          return;
+          }
+        }
+
+      // raw deflate stream - zip headers are written by miniz, on flush
+      const int flg = int(tdefl_create_comp_flags_from_zip_params(lv,-MZ_DEFAULT_WINDOW_BITS,MZ_DEFAULT_STRATEGY));
+      size_t    sz  = 0;
+      void*     buf = tdefl_compress_mem_to_heap(e->data.data(),e->data.size(),&sz,flg);
+      if(buf!=nullptr && sz<e->data.size()) {
+        std::memcpy(e->data.data(),buf,sz);
+        e->data.resize(sz);
+        e->deflated = true;
+        }
+      mz_free(buf);
+      });
+    }
+  pending.emplace_back(std::move(e));
+
+  if(pendingSize>PendingMax)
+    flushEntries();
+  }
+
+void Serialize::flushEntries() {
+  if(deflate!=nullptr)
+    deflate->wait();
+
+  for(auto& e:pending) {
+    const bool     deflated = e->reuse ? e->reuse->deflated : e->deflated;
+    const auto&    data     = e->reuse ? e->reuse->data     : e->data;
+    mz_bool        status   = MZ_FALSE;
+    if(deflated) {
+      const mz_uint lv = mz_uint(deflateLevel(level));
+      status = mz_zip_writer_add_mem_ex(&impl, e->name.c_str(), data.data(), data.size(), nullptr, 0,
+                                        lv | MZ_ZIP_FLAG_COMPRESSED_DATA, e->size, e->crc);
+      } else {
+      status = mz_zip_writer_add_mem(&impl, e->name.c_str(), data.data(), data.size(), MZ_NO_COMPRESSION);
+      }
+    if(status && cache!=nullptr && (e->reuse!=nullptr || e->hashed)) {
+      auto& c = cache->entries[e->name];
+      if(e->reuse==nullptr) {
+        c.size     = e->size;
+        c.crc      = e->crc;
+        c.hash     = e->hash;
+        c.deflated = e->deflated;
+        c.data     = std::move(e->data);
+        }
+      c.gen = cache->gen;
+      }
+    if(!status) {
+      pending.clear();
+      pendingSize = 0;
+      throw std::runtime_error("unable to write entry in game archive");
+      }
+    }
+  pending.clear();
+  pendingSize = 0;
   }
 
 bool Serialize::implSetEntry(std::string fname) {
@@ -97,15 +204,9 @@ bool Serialize::implSetEntry(std::string fname) {
   if(fout!=nullptr) {
     for(size_t i=0; i<entryName.size(); ++i) {
       if(entryName[i]=='/' && i+1<entryName.size()) {
-        const char prev = entryName[i+1];
-        entryName[i+1] = '\0';
-        mz_uint32 id = mz_uint32(-1);
-        if(!mz_zip_reader_locate_file_v2(&impl, entryName.c_str(), nullptr, 0, &id)) {
-          mz_bool status = mz_zip_writer_add_mem(&impl, entryName.c_str(), NULL, 0, MZ_NO_COMPRESSION);
-          if(!status)
-            throw std::runtime_error("unable to allocate entry in game archive");
-          }
-        entryName[i+1] = prev;
+        auto dir = entryName.substr(0,i+1);
+        if(dirs.insert(dir).second)
+          pushEntry(std::move(dir),{});
         }
       }
     return true;
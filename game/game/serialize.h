@@ -7,6 +7,9 @@
 #include <Tempest/Matrix4x4>
 
 #include <vector>
+#include <memory>
+#include <unordered_set>
+#include <unordered_map>
 #include <cstdint>
 #include <array>
 #include <type_traits>
@@ -21,6 +24,7 @@
 
 #include "gametime.h"
 #include "constants.h"
+#include "utils/workers.h"
 
 class WayPoint;
 class Npc;
@@ -30,10 +34,36 @@ class FpLock;
 class ScriptFn;
 class SaveGameHeader;
 
+// compressed entries of previous save, to skip deflate of unchanged data
+class SerializeCache final {
+  public:
+    void   clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+
+  private:
+    struct Entry {
+      size_t               size     = 0;
+      uint32_t             crc      = 0;
+      uint64_t             hash     = 0;
+      uint32_t             gen      = 0;
+      bool                 deflated = false;
+      std::vector<uint8_t> data;
+      };
+    std::unordered_map<std::string,Entry> entries;
+    uint32_t                              gen = 0;
+
+  friend class Serialize;
+  };
+
 class Serialize {
   public:
     enum Version : uint16_t {
-      Current = 42
+      Current = 43
+      };
+    enum class Compression : uint8_t {
+      Store    = 0,
+      Fast     = 1,
+      Balanced = 2,
       };
     Serialize(Tempest::ODevice& fout);
     Serialize(Tempest::IDevice&  fin);
@@ -45,6 +75,10 @@ class Serialize {
     uint16_t globalVersion()        const { return curVer; }
     void     setGlobalVersion(uint16_t v) { curVer = v;    }
 
+    Compression compression() const           { return level; }
+    void        setCompression(Compression c) { level = c;    }
+    void        setCache(SerializeCache* c);
+
     template<class ... Args>
     bool setEntry(const Args& ... args) {
       std::stringstream s;
@@ -273,7 +307,20 @@ class Serialize {
     static size_t writeFunc(void *pOpaque, uint64_t file_ofs, const void *pBuf, size_t n);
     static size_t readFunc (void *pOpaque, uint64_t file_ofs, void *pBuf, size_t n);
 
+    struct PendingEntry {
+      std::string          name;
+      std::vector<uint8_t> data;
+      size_t               size     = 0;
+      uint32_t             crc      = 0;
+      uint64_t             hash     = 0;
+      bool                 hashed   = false;
+      bool                 deflated = false;
+      const SerializeCache::Entry* reuse = nullptr;
+      };
+
     void   closeEntry();
+    void   pushEntry(std::string name, std::vector<uint8_t>&& data);
+    void   flushEntries();
     bool   implSetEntry(std::string e);
     uint32_t implDirectorySize(std::string e);
 
@@ -290,5 +337,13 @@ class Serialize {
     uint64_t                 readOffset = 0;
     Tempest::ODevice*        fout      = nullptr;
     Tempest::IDevice*        fin       = nullptr;
+
+    // entries are deflated on workers and appended to archive in order
+    Compression                                level = Compression::Balanced;
+    std::unordered_set<std::string>            dirs;
+    std::vector<std::unique_ptr<PendingEntry>> pending;
+    size_t                                     pendingSize = 0;
+    SerializeCache*                            cache       = nullptr;
+    std::unique_ptr<Workers::TaskGroup>        deflate;
   };
 
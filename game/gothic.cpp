@@ -62,6 +62,9 @@ Gothic::Gothic() {
   defaults->set("GAME", "animatedWindows",     1);
   defaults->set("GAME", "useGothic1Controls",  0);
   defaults->set("GAME", "highlightMeleeFocus", 0);
+  defaults->set("GAME", "saveCompression",     2);
+  defaults->set("GAME", "deltaSave",           1);
+  defaults->set("GAME", "debugAnimMemory",     0);
 
   defaults->set("SKY_OUTDOOR", "zSunName",   "unsun5.tga");
   defaults->set("SKY_OUTDOOR", "zSunSize",   200);
@@ -81,6 +84,7 @@ Gothic::Gothic() {
   defaults->set("ENGINE", "zWindEnabled",       1);
   defaults->set("ENGINE", "zWindCycleTime",     4);
   defaults->set("ENGINE", "zWindCycleTimeVar",  6);
+  defaults->set("ENGINE", "zMaxParticles",      20000);
 
   defaults->set("KEYS", "keyEnd",         "0100");
   defaults->set("KEYS", "keyHeal",        "2300");
@@ -570,33 +574,21 @@ std::unique_ptr<phoenix::vm> Gothic::createPhoenixVm(std::string_view datFile) {
   return vm;
   }
 
-std::vector<uint8_t> Gothic::loadScriptCode(std::string_view datFile) {
+phoenix::buffer Gothic::loadScriptCode(std::string_view datFile) {
+  // no copy: view into vdf archive, or mapped file
   if(Resources::hasFile(datFile))
-    return Resources::getFileData(datFile);
+    return Resources::getFileBuffer(datFile);
 
   auto gscript = CommandLine::inst().scriptPath();
   char16_t str16[256] = {};
   for(size_t i=0; i<datFile.size() && i<255; ++i)
     str16[i] = char16_t(datFile[i]);
   auto path = caseInsensitiveSegment(gscript,str16,Dir::FT_File);
-  Tempest::RFile f(path);
-  std::vector<uint8_t> ret(f.size());
-  f.read(ret.data(),ret.size());
-  return ret;
+  return phoenix::buffer::mmap(path);
   }
 
 phoenix::script Gothic::loadPhoenixScriptCode(std::string_view datFile) {
-  if(Resources::hasFile(datFile)) {
-    auto buf = Resources::getFileBuffer(datFile);
-    return phoenix::script::parse(buf);
-    }
-
-  auto gscript = CommandLine::inst().scriptPath();
-  char16_t str16[256] = {};
-  for(size_t i=0; i<datFile.size() && i<255; ++i)
-    str16[i] = char16_t(datFile[i]);
-  auto path = caseInsensitiveSegment(gscript,str16,Dir::FT_File);
-  auto buf = phoenix::buffer::mmap(path);
+  auto buf = loadScriptCode(datFile);
   return phoenix::script::parse(buf);
   }
 
@@ -1,5 +1,13 @@
 #include "frustrum.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define FRUSTRUM_SSE 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FRUSTRUM_NEON 1
+#endif
+
 using namespace Tempest;
 
 void Frustrum::make(const Matrix4x4& m, int32_t w, int32_t h) {
@@ -153,3 +161,54 @@ Frustrum::Ret Frustrum::testBbox(const Tempest::Vec3& min, const Tempest::Vec3&
     }
   return ret;
   }
+
+uint32_t Frustrum::testSpheres(const float* x, const float* y, const float* z, const float* R) const {
+  // same rules as testPoint(p,R,dist): far plane is inclusive
+  uint32_t ret = 0;
+#if defined(FRUSTRUM_SSE)
+  for(int b=0; b<32; b+=4) {
+    const __m128 px = _mm_loadu_ps(x+b);
+    const __m128 py = _mm_loadu_ps(y+b);
+    const __m128 pz = _mm_loadu_ps(z+b);
+    const __m128 nr = _mm_sub_ps(_mm_setzero_ps(),_mm_loadu_ps(R+b));
+    __m128 vis = _mm_castsi128_ps(_mm_set1_epi32(-1));
+    for(int i=0; i<6; ++i) {
+      __m128 d = _mm_mul_ps(px,_mm_set1_ps(f[i][0]));
+      d   = _mm_add_ps(d,_mm_mul_ps(py,_mm_set1_ps(f[i][1])));
+      d   = _mm_add_ps(d,_mm_mul_ps(pz,_mm_set1_ps(f[i][2])));
+      d   = _mm_add_ps(d,_mm_set1_ps(f[i][3]));
+      vis = _mm_and_ps(vis, i<5 ? _mm_cmpgt_ps(d,nr) : _mm_cmpge_ps(d,nr));
+      }
+    ret |= uint32_t(_mm_movemask_ps(vis)) << b;
+    }
+#elif defined(FRUSTRUM_NEON)
+  static const uint32_t bits[4] = {1,2,4,8};
+  const uint32x4_t bit = vld1q_u32(bits);
+  for(int b=0; b<32; b+=4) {
+    const float32x4_t px = vld1q_f32(x+b);
+    const float32x4_t py = vld1q_f32(y+b);
+    const float32x4_t pz = vld1q_f32(z+b);
+    const float32x4_t nr = vnegq_f32(vld1q_f32(R+b));
+    uint32x4_t vis = vdupq_n_u32(0xFFFFFFFF);
+    for(int i=0; i<6; ++i) {
+      float32x4_t d = vmulq_n_f32(px,f[i][0]);
+      d   = vmlaq_n_f32(d,py,f[i][1]);
+      d   = vmlaq_n_f32(d,pz,f[i][2]);
+      d   = vaddq_f32(d,vdupq_n_f32(f[i][3]));
+      vis = vandq_u32(vis, i<5 ? vcgtq_f32(d,nr) : vcgeq_f32(d,nr));
+      }
+    ret |= vaddvq_u32(vandq_u32(vis,bit)) << b;
+    }
+#else
+  for(int b=0; b<32; ++b) {
+    bool vis = true;
+    for(int i=0; i<6 && vis; ++i) {
+      const float d = f[i][0]*x[b]+f[i][1]*y[b]+f[i][2]*z[b]+f[i][3];
+      vis = (i<5) ? (d>-R[b]) : (d>=-R[b]);
+      }
+    if(vis)
+      ret |= (1u << b);
+    }
+#endif
+  return ret;
+  }
@@ -19,6 +19,9 @@ class Frustrum {
       };
     Ret  testBbox (const Tempest::Vec3& min, const Tempest::Vec3& max) const;
 
+    // tests 32 spheres, stored as SoA; bit 'i' of result is set if sphere 'i' is visible
+    uint32_t testSpheres(const float* x, const float* y, const float* z, const float* R) const;
+
     float              f[6][4] = {};
     Tempest::Matrix4x4 mat;
     uint32_t           width  = 0;
@@ -2,6 +2,9 @@
 
 #include <Tempest/Log>
 
+#include <bit>
+#include <limits>
+
 #include "frustrum.h"
 #include "visibleset.h"
 #include "utils/workers.h"
@@ -34,13 +37,17 @@ VisibilityGroup::Token::~Token() {
   t.vSet = nullptr;
   group->freeList.push_back(id);
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->statRemove(id);
+  else if(group==&owner->def)
+    owner->defTouch(id);
   }
 
 void VisibilityGroup::Token::setObject(VisibleSet* b, size_t i) {
   auto& t = group->tokens[id];
   t.vSet = b;
   t.id   = i;
+  if(group==&owner->def)
+    owner->defTouch(id);
   }
 
 void VisibilityGroup::Token::setObjMatrix(const Matrix4x4& at) {
@@ -50,7 +57,9 @@ void VisibilityGroup::Token::setObjMatrix(const Matrix4x4& at) {
   t.pos        = at;
   t.updateBbox = true;
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->statTouch(id);
+  else if(group==&owner->def)
+    owner->defTouch(id);
   }
 
 void VisibilityGroup::Token::setGroup(Group gr) {
@@ -69,10 +78,20 @@ void VisibilityGroup::Token::setGroup(Group gr) {
     } else {
     g.tokens.push_back(group->tokens[id]);
     id = g.tokens.size()-1;
+    if(&g==&owner->def)
+      owner->defMoved.resize(g.tokens.size());
     }
+  if(group==&owner->stat)
+    owner->statRemove(prevId);
   group->tokens[prevId] = Tok();
   group->freeList.push_back(prevId);
+  if(group==&owner->def)
+    owner->defTouch(prevId);
   group = &g;
+  if(group==&owner->stat)
+    owner->statInsert(id);
+  else if(group==&owner->def)
+    owner->defTouch(id);
   }
 
 void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
@@ -82,7 +101,9 @@ void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
   t.bbox       = bbox;
   t.updateBbox = true;
   if(group==&owner->stat)
-    owner->updateThree = true;
+    owner->statTouch(id);
+  else if(group==&owner->def)
+    owner->defTouch(id);
   }
 
 const Bounds& VisibilityGroup::Token::bounds() const {
@@ -94,6 +115,14 @@ const Bounds& VisibilityGroup::Token::bounds() const {
   return t.bbox;
   }
 
+bool VisibilityGroup::Token::isVisible() const {
+  if(group==nullptr)
+    return false;
+  if(group!=&owner->def)
+    return true; // static tokens are not tracked per token
+  return owner->isDefVisible(id);
+  }
+
 VisibilityGroup::VisibilityGroup(const std::pair<Vec3, Vec3>& bbox) {
   def .freeList.reserve(4);
   stat.freeList.reserve(4);
@@ -108,52 +137,292 @@ VisibilityGroup::TokList& VisibilityGroup::group(Group gr) {
   return def;
   }
 
-void VisibilityGroup::buildTree() {
-  treeTok.resize(stat.tokens.size());
+static void projectBbox(const Bounds& bbox, const Matrix4x4& pos, Vec3 out[2]) {
+  auto& b = bbox.bbox;
+  Vec3 pt[8] = {
+    {b[0].x,b[0].y,b[0].z},
+    {b[1].x,b[0].y,b[0].z},
+    {b[0].x,b[1].y,b[0].z},
+    {b[1].x,b[1].y,b[0].z},
+
+    {b[0].x,b[0].y,b[1].z},
+    {b[1].x,b[0].y,b[1].z},
+    {b[0].x,b[1].y,b[1].z},
+    {b[1].x,b[1].y,b[1].z},
+    };
+  for(auto& i:pt)
+    pos.project(i);
+
+  out[0] = pt[0];
+  out[1] = pt[1];
+  for(auto& i:pt) {
+    out[0].x = std::min(out[0].x, i.x);
+    out[0].y = std::min(out[0].y, i.y);
+    out[0].z = std::min(out[0].z, i.z);
+    out[1].x = std::max(out[1].x, i.x);
+    out[1].y = std::max(out[1].y, i.y);
+    out[1].z = std::max(out[1].z, i.z);
+    }
+  }
+
+void VisibilityGroup::defTouch(size_t id) {
+  // token-local write only: may run on any thread
+  defMoved[id] = 1;
+  }
+
+void VisibilityGroup::updateDefSpheres() {
+  const size_t sz = ((def.tokens.size()+31)/32)*32;
+  if(defX.size()<sz) {
+    defX.resize(sz);
+    defY.resize(sz);
+    defZ.resize(sz);
+    defR.resize(sz,-std::numeric_limits<float>::infinity());
+    defVis.resize(sz/32);
+    }
+
+  Workers::parallelFor(defMoved,[this](uint8_t& moved) {
+    if(moved==0)
+      return;
+    moved = 0;
+    const size_t id = size_t(&moved - defMoved.data());
+    auto&        t  = def.tokens[id];
+    if(t.vSet==nullptr) {
+      // never visible
+      defR[id] = -std::numeric_limits<float>::infinity();
+      return;
+      }
+    if(t.updateBbox) {
+      t.bbox.setObjMatrix(t.pos);
+      t.updateBbox = false;
+      }
+    defX[id] = t.bbox.midTr.x;
+    defY[id] = t.bbox.midTr.y;
+    defZ[id] = t.bbox.midTr.z;
+    defR[id] = t.bbox.r;
+    });
+  }
+
+bool VisibilityGroup::isDefVisible(size_t id) const {
+  if(id/32>=defVis.size())
+    return true; // not tested yet
+  auto&          blk = defVis[id/32];
+  const uint32_t bit = 1u << (id%32);
+  for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c)
+    if(blk.mask[c] & bit)
+      return true;
+  return false;
+  }
+
+void VisibilityGroup::testDefObjects(VisBlock& blk, const Frustrum f[]) {
+  const size_t b = size_t(std::distance(defVis.data(),&blk))*32;
+  for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c)
+    blk.mask[c] = f[c].testSpheres(&defX[b],&defY[b],&defZ[b],&defR[b]);
+
+  // compaction
+  for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c) {
+    for(uint32_t m=blk.mask[c]; m!=0; m&=(m-1)) {
+      auto& t = def.tokens[b+size_t(std::countr_zero(m))];
+      if(t.vSet!=nullptr)
+        t.vSet->push(t.id,SceneGlobals::VisCamera(c));
+      }
+    }
+  }
+
+void VisibilityGroup::statInsert(size_t id) {
+  if(statInfo.size()<=id)
+    statInfo.resize(stat.tokens.size());
+  auto& s = statInfo[id];
+  s.alive   = true;
+  s.treeItm = NoItm;
+  if(!s.pending) {
+    s.pending = true;
+    statPending.push_back(id);
+    }
+  statTouch(id);
+  }
+
+void VisibilityGroup::statRemove(size_t id) {
+  auto& s = statInfo[id];
+  s.alive = false;
+  s.version++;
+  if(s.treeItm!=NoItm) {
+    // lazy removal: leaf stays in tree until next rebuild
+    tree.tok[s.treeItm].self = NoItm;
+    s.treeItm = NoItm;
+    ++treeDead;
+    }
+  }
+
+void VisibilityGroup::statTouch(size_t id) {
+  // token-local write only: may run on any thread
+  statInfo[id].dirty = true;
+  }
+
+void VisibilityGroup::updateTree() {
+  finishRebuild();
+
+  for(size_t id=0; id<statInfo.size(); ++id) {
+    auto& s = statInfo[id];
+    if(!s.dirty)
+      continue;
+    s.dirty = false;
+    s.version++;
+    if(!s.alive)
+      continue;
+    auto& t = stat.tokens[id];
+    projectBbox(t.bbox,t.pos,s.bbox);
+    if(s.treeItm!=NoItm)
+      refit(s.treeItm,s.bbox);
+    }
+
+  size_t cnt = 0;
+  for(auto id:statPending) {
+    auto& s = statInfo[id];
+    if(s.alive && s.treeItm==NoItm)
+      statPending[cnt++] = id; else
+      s.pending = false;
+    }
+  statPending.resize(cnt);
+
+  if(rebuilding)
+    return;
+  // pending tokens are tested one by one and dead/refitted leafs degrade the tree:
+  // rebuild, once it's about 1/8 of the tree
+  const size_t changes = treeDead + treeRefit + statPending.size();
+  if(changes*8 <= tree.tok.size()+64)
+    return;
+  startRebuild(tree.tok.size()>treeDead);
+  }
 
-  size_t tSz = 0;
-  for(auto& t:stat.tokens) {
-    if(t.vSet==nullptr)
+void VisibilityGroup::startRebuild(bool async) {
+  next.tok.clear();
+  next.tok.reserve(statInfo.size());
+  for(size_t id=0; id<statInfo.size(); ++id) {
+    auto& s = statInfo[id];
+    if(!s.alive)
       continue;
-    auto& b = t.bbox.bbox;
-    Vec3 pt[8] = {
-      {b[0].x,b[0].y,b[0].z},
-      {b[1].x,b[0].y,b[0].z},
-      {b[0].x,b[1].y,b[0].z},
-      {b[1].x,b[1].y,b[0].z},
-
-      {b[0].x,b[0].y,b[1].z},
-      {b[1].x,b[0].y,b[1].z},
-      {b[0].x,b[1].y,b[1].z},
-      {b[1].x,b[1].y,b[1].z},
-      };
-    for(auto& i:pt)
-      t.pos.project(i);
-
-    auto& tx = treeTok[tSz];
-    tx.self    = &t;
-    tx.bbox[0] = pt[0];
-    tx.bbox[1] = pt[1];
-    for(auto& i:pt) {
-      tx.bbox[0].x = std::min(tx.bbox[0].x, i.x);
-      tx.bbox[0].y = std::min(tx.bbox[0].y, i.y);
-      tx.bbox[0].z = std::min(tx.bbox[0].z, i.z);
-      tx.bbox[1].x = std::max(tx.bbox[1].x, i.x);
-      tx.bbox[1].y = std::max(tx.bbox[1].y, i.y);
-      tx.bbox[1].z = std::max(tx.bbox[1].z, i.z);
+    TreeItm tx;
+    tx.self    = id;
+    tx.version = s.version;
+    tx.bbox[0] = s.bbox[0];
+    tx.bbox[1] = s.bbox[1];
+    tx.midTr   = (tx.bbox[1]+tx.bbox[0])*0.5f;
+    tx.r       = (tx.bbox[1]-tx.bbox[0]).length()*0.5f;
+    next.tok.push_back(tx);
+    }
+
+  if(!async) {
+    buildTree(next);
+    swapTree();
+    return;
+    }
+  // old tree stays in use, until new one is ready; background queue keeps
+  // the build off the render thread, when it helps in pass() wait
+  rebuilding = true;
+  rebuildDone.store(false);
+  rebuildTask.runBackground([this]() {
+    try {
+      buildTree(next);
+      }
+    catch(...) {
+      // error is rethrown by finishRebuild
+      rebuildDone.store(true);
+      throw;
+      }
+    rebuildDone.store(true);
+    });
+  }
+
+void VisibilityGroup::finishRebuild() {
+  if(!rebuilding || !rebuildDone.load())
+    return;
+  rebuilding = false;
+  rebuildTask.wait();
+  swapTree();
+  }
+
+void VisibilityGroup::swapTree() {
+  std::swap(tree,next);
+  treeDead  = 0;
+  treeRefit = 0;
+
+  for(auto& s:statInfo)
+    s.treeItm = NoItm;
+  for(size_t i=0; i<tree.tok.size(); ++i) {
+    auto& tx = tree.tok[i];
+    auto& s  = statInfo[tx.self];
+    if(s.alive && s.version==tx.version) {
+      s.treeItm = i;
+      } else {
+      // removed or changed, while tree was building
+      tx.self = NoItm;
+      ++treeDead;
+      }
+    }
+
+  statPending.clear();
+  for(size_t id=0; id<statInfo.size(); ++id) {
+    auto& s = statInfo[id];
+    s.pending = (s.alive && s.treeItm==NoItm);
+    if(s.pending)
+      statPending.push_back(id);
+    }
+  }
+
+void VisibilityGroup::refit(size_t itm, const Vec3* bbox) {
+  auto& tx = tree.tok[itm];
+  tx.bbox[0] = bbox[0];
+  tx.bbox[1] = bbox[1];
+  tx.midTr   = (tx.bbox[1]+tx.bbox[0])*0.5f;
+  tx.r       = (tx.bbox[1]-tx.bbox[0]).length()*0.5f;
+
+  if(tree.node.size()<=1)
+    return;
+  // same split, as in buildTree
+  size_t node = 1, b = 0, e = tree.tok.size();
+  while(!tree.node[node].isLeaf) {
+    const size_t mid = b+(e-b)/2;
+    if(itm<mid) {
+      node = node*2+0;
+      e    = mid;
+      } else {
+      node = node*2+1;
+      b    = mid;
       }
-    tx.midTr = (tx.bbox[1]+tx.bbox[0])*0.5f;
-    ++tSz;
+    if(tree.node.size()<=node)
+      return;
+    }
+
+  // grow-only: nodes stay conservative, tree quality is restored by rebuild
+  bool grown = false;
+  for(; node>0; node/=2) {
+    auto& n  = tree.node[node].bbox;
+    Vec3  bx[2] = {n.bbox[0], n.bbox[1]};
+    bx[0].x = std::min(bx[0].x, bbox[0].x);
+    bx[0].y = std::min(bx[0].y, bbox[0].y);
+    bx[0].z = std::min(bx[0].z, bbox[0].z);
+    bx[1].x = std::max(bx[1].x, bbox[1].x);
+    bx[1].y = std::max(bx[1].y, bbox[1].y);
+    bx[1].z = std::max(bx[1].z, bbox[1].z);
+    if(bx[0]==n.bbox[0] && bx[1]==n.bbox[1])
+      break;
+    n.assign(bx);
+    grown = true;
     }
-  treeTok .resize(tSz);
-  treeNode.resize(tSz);
-  treeNode.resize(2); // dummy node + root
-  buildTree(1,treeTok.data(),treeTok.data()+treeTok.size(),0);
+  if(grown)
+    ++treeRefit;
+  }
+
+void VisibilityGroup::buildTree(Tree& t) {
+  t.node.resize(2); // dummy node + root
+  buildTree(t,1,t.tok.data(),t.tok.data()+t.tok.size(),0);
 
   uint8_t maxTh = Workers::maxThreads();
   size_t  depth = 1;
 
-  if(maxTh>=8)
+  if(maxTh>=16)
+    depth = 4;
+  else if(maxTh>=8)
     depth = 3;
   else if(maxTh>=4)
     depth = 2;
@@ -161,11 +430,11 @@ void VisibilityGroup::buildTree() {
     depth = 1;
   else if(maxTh>=0)
     depth = 0;
-  treeTasks.clear();
-  buildTreeTasks(1,depth,treeTok.data(),treeTok.data()+treeTok.size());
+  t.tasks.clear();
+  buildTreeTasks(t,1,depth,t.tok.data(),t.tok.data()+t.tok.size());
   }
 
-void VisibilityGroup::buildTree(size_t node, TreeItm* begin, TreeItm* end, size_t step) {
+void VisibilityGroup::buildTree(Tree& t, size_t node, TreeItm* begin, TreeItm* end, size_t step) {
   size_t sz = size_t(std::distance(begin,end));
 
   Vec3 bbox[2] = {};
@@ -185,18 +454,18 @@ void VisibilityGroup::buildTree(size_t node, TreeItm* begin, TreeItm* end, size_
 
   Node n;
   n.bbox.assign(bbox);
-  treeNode[node] = n;
+  t.node[node] = n;
 
   const float blockSz = 5*100;
   const auto  boxSz   = bbox[1]-bbox[0];
   if(sz<16 || (boxSz.x<blockSz && boxSz.y<blockSz && boxSz.z<blockSz)) {
-    treeNode[node].isLeaf = true;
+    t.node[node].isLeaf = true;
     return;
     }
 
   if(step==0) {
     std::sort(begin,end,[](const TreeItm& l, const TreeItm& r) {
-      return l.self->bbox.r < r.self->bbox.r;
+      return l.r < r.r;
       });
     }
   else switch(step%3) {
@@ -220,26 +489,26 @@ void VisibilityGroup::buildTree(size_t node, TreeItm* begin, TreeItm* end, size_
       }
     }
 
-  treeNode.resize(std::max(treeNode.size(),node*2+2));
-  buildTree(node*2+0, begin,      begin+sz/2, step+1);
-  buildTree(node*2+1, begin+sz/2, begin+sz,   step+1);
+  t.node.resize(std::max(t.node.size(),node*2+2));
+  buildTree(t, node*2+0, begin,      begin+sz/2, step+1);
+  buildTree(t, node*2+1, begin+sz/2, begin+sz,   step+1);
   }
 
-void VisibilityGroup::buildTreeTasks(size_t node, size_t depth, TreeItm* begin, TreeItm* end) {
-  if(treeNode.size()<=node)
+void VisibilityGroup::buildTreeTasks(Tree& t, size_t node, size_t depth, TreeItm* begin, TreeItm* end) {
+  if(t.node.size()<=node)
     return;
-  auto& n = treeNode[node];
+  auto& n = t.node[node];
   if(n.isLeaf || depth==0) {
     TreeTask task = {};
     task.begin = begin;
     task.end   = end;
     task.node  = node;
-    treeTasks.push_back(task);
+    t.tasks.push_back(task);
     return;
     }
   auto sz = size_t(std::distance(begin,end));
-  buildTreeTasks(node*2+0, depth-1, begin,      begin+sz/2);
-  buildTreeTasks(node*2+1, depth-1, begin+sz/2, begin+sz  );
+  buildTreeTasks(t, node*2+0, depth-1, begin,      begin+sz/2);
+  buildTreeTasks(t, node*2+1, depth-1, begin+sz/2, begin+sz  );
   }
 
 VisibilityGroup::Token VisibilityGroup::get(Group g) {
@@ -250,36 +519,53 @@ VisibilityGroup::Token VisibilityGroup::get(Group g) {
     gr.freeList.pop_back();
     } else {
     gr.tokens.emplace_back();
+    if(&gr==&def)
+      defMoved.resize(gr.tokens.size());
     }
-  if(&gr==&stat) {
-    updateThree = true;
-    }
+  if(&gr==&stat)
+    statInsert(id);
+  else if(&gr==&def)
+    defTouch(id);
   return Token(*this, gr,id);
   }
 
 void VisibilityGroup::pass(const Frustrum f[]) {
-  if(updateThree) {
-    buildTree();
-    updateThree = false;
-    }
+  updateTree();
+  updateDefSpheres();
 
-  Workers::parallelFor(resetableSets,[](VisibleSet *v){
-    v->reset();
+  Workers::TaskGroup vis;
+  auto reset = vis.run([this](){
+    Workers::parallelFor(resetableSets,[](VisibleSet *v){
+      v->reset();
+      });
     });
 
-  for(auto& t:alwaysVis.tokens) {
-    if(t.vSet==nullptr)
-      continue;
-    t.vSet->push(t.id,SceneGlobals::V_Shadow0);
-    t.vSet->push(t.id,SceneGlobals::V_Shadow1);
-    t.vSet->push(t.id,SceneGlobals::V_Main);
-    }
+  vis.run([this](){
+    for(auto& t:alwaysVis.tokens) {
+      if(t.vSet==nullptr)
+        continue;
+      t.vSet->push(t.id,SceneGlobals::V_Shadow0);
+      t.vSet->push(t.id,SceneGlobals::V_Shadow1);
+      t.vSet->push(t.id,SceneGlobals::V_Main);
+      }
+    },{reset});
 
-  testStaticObjectsThreaded(f);
+  // static and dynamic objects are tested concurrently
+  testStaticObjectsThreaded(vis,reset,f);
 
-  Workers::parallelFor(def.tokens,[&f](Tok& t) {
-    testVisibility(t,f);
-    });
+  // not yet in the tree
+  vis.run([this,f](){
+    Workers::parallelFor(statPending,[this,f](size_t id) {
+      testVisibility(stat.tokens[id],f);
+      });
+    },{reset});
+
+  vis.run([this,f](){
+    Workers::parallelFor(defVis,[this,f](VisBlock& blk) {
+      testDefObjects(blk,f);
+      });
+    },{reset});
+  vis.wait();
   }
 
 void VisibilityGroup::buildVSetIndex(const std::vector<ObjectsBucket*>& index) {
@@ -293,26 +579,30 @@ void VisibilityGroup::buildVSetIndex(const std::vector<ObjectsBucket*>& index) {
   std::sort(resetableSets.begin(),resetableSets.end());
   }
 
-void VisibilityGroup::testStaticObjectsThreaded(const Frustrum f[]) {
-  Workers::parallelTasks(treeTasks.size(),[&](uintptr_t taskId) {
-    auto& t = treeTasks[taskId];
-    for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c)
-      testStaticObjects(f,SceneGlobals::VisCamera(c),t.node, t.begin,t.end);
-    });
+void VisibilityGroup::testStaticObjectsThreaded(Workers::TaskGroup& vis, const Workers::Task& reset, const Frustrum f[]) {
+  for(auto& t:tree.tasks) {
+    vis.run([this,&t,f](){
+      for(uint8_t c=SceneGlobals::V_Shadow0; c<SceneGlobals::V_Count; ++c)
+        testStaticObjects(f,SceneGlobals::VisCamera(c),t.node, t.begin,t.end);
+      },{reset});
+    }
   }
 
 void VisibilityGroup::setVisible(SceneGlobals::VisCamera c, TreeItm* begin, TreeItm* end) {
   for(auto i=begin; i!=end; ++i) {
-    auto& v = *i->self->vSet;
-    v.push(i->self->id, c);
+    if(i->self==NoItm)
+      continue;
+    auto& t = stat.tokens[i->self];
+    if(t.vSet!=nullptr)
+      t.vSet->push(t.id, c);
     }
   }
 
 void VisibilityGroup::testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c,
                                         size_t node, TreeItm* begin, TreeItm* end) {
-  if(treeNode.size()<=node)
+  if(tree.node.size()<=node)
     return;
-  auto& n       = treeNode[node];
+  auto& n       = tree.node[node];
   auto  visible = f[c].testBbox(n.bbox.bbox[0],n.bbox.bbox[1]);
 
   if(n.isLeaf || visible==Frustrum::T_Full) {
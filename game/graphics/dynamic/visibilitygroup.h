@@ -2,9 +2,11 @@
 
 #include <Tempest/Matrix4x4>
 #include <cstdint>
+#include <atomic>
 
 #include "graphics/sceneglobals.h"
 #include "graphics/bounds.h"
+#include "utils/workers.h"
 
 class Frustrum;
 class VisibleSet;
@@ -36,6 +38,7 @@ class VisibilityGroup {
         void   setBounds   (const Bounds& bbox);
 
         const Bounds& bounds() const;
+        bool          isVisible() const;
 
       private:
         Token(VisibilityGroup& owner, TokList& group, size_t id);
@@ -65,8 +68,33 @@ class VisibilityGroup {
       };
     TokList def, stat, alwaysVis;
 
+    static constexpr size_t NoItm = size_t(-1);
+
+    // bounding spheres of 'def' tokens as SoA, padded to blocks of 32
+    struct VisBlock {
+      uint32_t mask[SceneGlobals::V_Count] = {};
+      };
+    std::vector<float>       defX, defY, defZ, defR;
+    std::vector<VisBlock>    defVis;
+    // per-token flag; set concurrently from animation threads, gathered in pass()
+    std::vector<uint8_t>     defMoved;
+
+    // per-token state of static tree, indexed same as stat.tokens
+    struct StatInfo {
+      Tempest::Vec3 bbox[2];
+      size_t        treeItm = NoItm;
+      uint32_t      version = 0;
+      bool          alive   = false;
+      bool          pending = false;
+      bool          dirty   = false;
+      };
+    std::vector<StatInfo>    statInfo;
+    std::vector<size_t>      statPending;
+
     struct TreeItm {
-      Tok*          self = nullptr;
+      size_t        self    = NoItm;
+      uint32_t      version = 0;
+      float         r       = 0;
       Tempest::Vec3 bbox[2];
       Tempest::Vec3 midTr;
       };
@@ -80,22 +108,45 @@ class VisibilityGroup {
       TreeItm* end   = nullptr;
       size_t   node  = 0;
       };
-    std::vector<Node>        treeNode;
-    std::vector<TreeItm>     treeTok;
-    std::vector<TreeTask>    treeTasks;
+    struct Tree {
+      std::vector<Node>      node;
+      std::vector<TreeItm>   tok;
+      std::vector<TreeTask>  tasks;
+      };
+    // 'next' is owned by rebuild task, until rebuildDone is set
+    Tree                     tree, next;
+    size_t                   treeDead   = 0;
+    size_t                   treeRefit  = 0;
+    bool                     rebuilding = false;
+    std::atomic_bool         rebuildDone{false};
+    // declared after 'next': destroyed (and awaited) first
+    Workers::TaskGroup       rebuildTask;
 
     std::vector<VisibleSet*> resetableSets;
 
-    bool                     updateThree = false;
+    void     defTouch  (size_t id);
+    void     updateDefSpheres();
+    bool     isDefVisible(size_t id) const;
+    void     testDefObjects(VisBlock& blk, const Frustrum f[]);
+
+    void     statInsert(size_t id);
+    void     statRemove(size_t id);
+    void     statTouch (size_t id);
+
+    void     updateTree();
+    void     startRebuild(bool async);
+    void     finishRebuild();
+    void     swapTree();
+    void     refit(size_t itm, const Tempest::Vec3* bbox);
 
-    void     buildTree();
-    void     buildTree(size_t node, TreeItm* begin, TreeItm* end, size_t step);
-    void     buildTreeTasks(size_t node, size_t depth, TreeItm* begin, TreeItm* end);
+    static void buildTree(Tree& t);
+    static void buildTree(Tree& t, size_t node, TreeItm* begin, TreeItm* end, size_t step);
+    static void buildTreeTasks(Tree& t, size_t node, size_t depth, TreeItm* begin, TreeItm* end);
     TokList& group(Group gr);
 
-    static void setVisible  (SceneGlobals::VisCamera c, TreeItm* begin, TreeItm* end);
+    void        setVisible  (SceneGlobals::VisCamera c, TreeItm* begin, TreeItm* end);
 
-    void        testStaticObjectsThreaded(const Frustrum f[]);
+    void        testStaticObjectsThreaded(Workers::TaskGroup& vis, const Workers::Task& reset, const Frustrum f[]);
     void        testStaticObjects(const Frustrum f[], SceneGlobals::VisCamera c,
                                   size_t node, TreeItm* begin, TreeItm* end);
     static void testVisibility(Tok& t, const Frustrum f[]);
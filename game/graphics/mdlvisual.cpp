@@ -463,7 +463,7 @@ bool MdlVisual::isUsingTorch() const {
   return torch.view!=nullptr;
   }
 
-bool MdlVisual::updateAnimation(Npc* npc, World& world, uint64_t dt) {
+bool MdlVisual::updateAnimation(Npc* npc, World& world, uint64_t dt, const Pose::Lod& lod) {
   Pose&    pose      = *skInst;
   uint64_t tickCount = world.tickCount();
   auto     pos3      = Vec3{pos.at(3,0), pos.at(3,1), pos.at(3,2)};
@@ -485,7 +485,7 @@ bool MdlVisual::updateAnimation(Npc* npc, World& world, uint64_t dt) {
 
   solver.update(tickCount);
   pose.setObjectMatrix(pos,false);
-  const bool changed = pose.update(tickCount);
+  const bool changed = pose.update(tickCount,lod);
 
   if(changed)
     view.setPose(pos,pose);
@@ -772,6 +772,12 @@ Bounds MdlVisual::bounds() const {
   return b;
   }
 
+bool MdlVisual::isVisible() const {
+  if(view.isEmpty() && head.view.isEmpty())
+    return true; // nothing to test: keep skeleton up to date for attachments
+  return view.isVisible() || head.view.isVisible();
+  }
+
 void MdlVisual::bind(MeshAttach& slot, MeshObjects::Mesh&& itm, std::string_view bone) {
   slot.boneId = skeleton==nullptr ? size_t(-1) : skeleton->findNode(bone);
   slot.view   = std::move(itm);
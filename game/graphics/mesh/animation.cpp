@@ -1,7 +1,9 @@
 #include "animation.h"
 
 #include <Tempest/Log>
+#include <algorithm>
 #include <cctype>
+#include <cmath>
 
 #include "utils/string_frm.h"
 #include "world/objects/npc.h"
@@ -93,8 +95,13 @@ const Animation::Sequence *Animation::sequenceAsc(std::string_view name) const {
   }
 
 void Animation::debug() const {
-  for(auto& i:sequences)
-    Log::d(i.name);
+  size_t raw = 0, packed = 0;
+  for(auto& i:sequences) {
+    Log::d(i.name," samples: ",i.data->rawSize()," -> ",i.data->packedSize()," bytes");
+    raw    += i.data->rawSize();
+    packed += i.data->packedSize();
+    }
+  Log::d("animation samples total: ",raw," -> ",packed," bytes");
   }
 
 std::string_view Animation::defaultMesh() const {
@@ -210,9 +217,8 @@ Animation::Sequence::Sequence(const phoenix::mds::animation& hdr, std::string_vi
   data->fpsRate = p.fps;
   data->numFrames = p.frame_count;
   data->nodeIndex = p.node_indices;
-  data->samples = p.samples;
-
-  setupMoveTr();
+  data->setupMoveTr(p.samples);
+  data->pack(p.samples);
   }
 
 bool Animation::Sequence::isFinished(uint64_t now, uint64_t sTime, uint16_t comboLen) const {
@@ -525,11 +531,7 @@ void Animation::Sequence::schemeName(char scheme[64]) const {
     }
   }
 
-void Animation::Sequence::setupMoveTr() {
-  data->setupMoveTr();
-  }
-
-void Animation::AnimData::setupMoveTr() {
+void Animation::AnimData::setupMoveTr(const std::vector<phoenix::animation_sample>& samples) {
   size_t sz = nodeIndex.size();
   if(sz==0)
     return;
@@ -568,6 +570,102 @@ void Animation::AnimData::setupMoveTr() {
     }
   }
 
+static constexpr float quatRange = 0.70710678f; // 1/sqrt(2): range of non-largest quaternion components
+
+static uint16_t packUnorm(float v, float mn, float scale, uint16_t maxV) {
+  if(scale<=0.f)
+    return 0;
+  float q = std::round((v-mn)/scale);
+  return uint16_t(std::clamp(q,0.f,float(maxV)));
+  }
+
+void Animation::AnimData::pack(const std::vector<phoenix::animation_sample>& src) {
+  const size_t sz = nodeIndex.size();
+  samples.clear();
+  posMin  .clear();
+  posScale.clear();
+  if(sz==0 || src.size()%sz!=0)
+    return;
+
+  posMin  .resize(sz);
+  posScale.resize(sz);
+  for(size_t i=0; i<sz; ++i) {
+    auto mn = src[i].position, mx = src[i].position;
+    for(size_t r=i; r<src.size(); r+=sz) {
+      auto& p = src[r].position;
+      mn.x = std::min(mn.x,p.x); mn.y = std::min(mn.y,p.y); mn.z = std::min(mn.z,p.z);
+      mx.x = std::max(mx.x,p.x); mx.y = std::max(mx.y,p.y); mx.z = std::max(mx.z,p.z);
+      }
+    posMin  [i] = Vec3(mn.x,mn.y,mn.z);
+    posScale[i] = Vec3(mx.x-mn.x,mx.y-mn.y,mx.z-mn.z)/65535.f;
+    }
+
+  samples.resize(src.size());
+  for(size_t i=0; i<src.size(); ++i) {
+    auto& s   = src[i];
+    auto& d   = samples[i];
+    auto& mn  = posMin  [i%sz];
+    auto& scl = posScale[i%sz];
+    d.pos[0] = packUnorm(s.position.x,mn.x,scl.x,65535);
+    d.pos[1] = packUnorm(s.position.y,mn.y,scl.y,65535);
+    d.pos[2] = packUnorm(s.position.z,mn.z,scl.z,65535);
+
+    float q[4] = {s.rotation.x, s.rotation.y, s.rotation.z, s.rotation.w};
+    float len  = std::sqrt(q[0]*q[0]+q[1]*q[1]+q[2]*q[2]+q[3]*q[3]);
+    if(len<=0.f) {
+      q[0] = q[1] = q[2] = 0;
+      q[3] = len = 1;
+      }
+    uint16_t mx = 0;
+    for(uint16_t r=1; r<4; ++r)
+      if(std::fabs(q[r])>std::fabs(q[mx]))
+        mx = r;
+    // q and -q is same rotation: keep largest component positive
+    const float sign = (q[mx]<0 ? -1.f : 1.f)/len;
+    for(uint16_t r=0, k=0; r<4; ++r) {
+      if(r==mx)
+        continue;
+      d.rot[k] = packUnorm(q[r]*sign,-quatRange,2.f*quatRange/32767.f,32767);
+      ++k;
+      }
+    d.rot[0] = uint16_t(d.rot[0] | ((mx&1)<<15));
+    d.rot[1] = uint16_t(d.rot[1] | ((mx>>1)<<15));
+    }
+  }
+
+phoenix::animation_sample Animation::AnimData::sample(size_t id) const {
+  auto& s   = samples[id];
+  auto& mn  = posMin  [id%posMin.size()];
+  auto& scl = posScale[id%posMin.size()];
+
+  phoenix::animation_sample r {};
+  r.position.x = mn.x + float(s.pos[0])*scl.x;
+  r.position.y = mn.y + float(s.pos[1])*scl.y;
+  r.position.z = mn.z + float(s.pos[2])*scl.z;
+
+  const uint16_t mx  = uint16_t((s.rot[0]>>15) | ((s.rot[1]>>15)<<1));
+  float          q[4] = {};
+  float          sq  = 0;
+  for(uint16_t i=0, k=0; i<4; ++i) {
+    if(i==mx)
+      continue;
+    q[i] = float(s.rot[k] & 0x7FFF)*(2.f*quatRange/32767.f) - quatRange;
+    sq  += q[i]*q[i];
+    ++k;
+    }
+  q[mx] = std::sqrt(std::max(0.f,1.f-sq));
+
+  r.rotation.x = q[0];
+  r.rotation.y = q[1];
+  r.rotation.z = q[2];
+  r.rotation.w = q[3];
+  return r;
+  }
+
+size_t Animation::AnimData::packedSize() const {
+  return samples.size()*sizeof(PackedSample) + (posMin.size()+posScale.size())*sizeof(Tempest::Vec3);
+  }
+
 void Animation::AnimData::setupEvents(float fpsRate) {
   if(fpsRate<=0.f)
     return;
@@ -38,11 +38,18 @@ class Animation final {
       std::vector<EvMorph> morph;
       };
 
+    // quantized sample: smallest-three rotation + range-quantized position
+    struct PackedSample final {
+      uint16_t rot[3] = {};
+      uint16_t pos[3] = {};
+      };
+
     struct AnimData final {
       Tempest::Vec3                               translate={};
       Tempest::Vec3                               moveTr={};
 
-      std::vector<phoenix::animation_sample>      samples;
+      std::vector<PackedSample>                   samples; // frame-major: [frame*nodeIndex.size()+node]
+      std::vector<Tempest::Vec3>                  posMin, posScale;
       std::vector<uint32_t>                       nodeIndex;
       std::vector<Tempest::Vec3>                  tr;
       bool                                        hasMoveTr=false;
@@ -65,8 +72,12 @@ class Animation final {
       std::vector<uint64_t>                       defParFrame;
       std::vector<uint64_t>                       defWindow;
 
-      void                                        setupMoveTr();
+      void                                        setupMoveTr(const std::vector<phoenix::animation_sample>& samples);
       void                                        setupEvents(float fpsRate);
+      void                                        pack(const std::vector<phoenix::animation_sample>& samples);
+      phoenix::animation_sample                   sample(size_t id) const;
+      size_t                                      rawSize()    const { return samples.size()*sizeof(phoenix::animation_sample); }
+      size_t                                      packedSize() const;
       };
 
     struct Sequence final {
@@ -112,7 +123,6 @@ class Animation final {
       std::shared_ptr<AnimData>              data;
 
       private:
-        void                                 setupMoveTr();
         static void                          processEvent(const phoenix::mds::event_tag& e, EvCount& ev, uint64_t time);
         bool                                 extractFrames(uint64_t &frameA, uint64_t &frameB, bool &invert, uint64_t barrier, uint64_t sTime, uint64_t now) const;
       };
@@ -2,6 +2,14 @@
 
 #include <cmath>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define ANIM_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define ANIM_NEON 1
+#endif
+
 static float mix(float x,float y,float a){
   return x+(y-x)*a;
   }
@@ -18,10 +26,8 @@ phoenix::animation_sample mix(const phoenix::animation_sample& x,const phoenix::
   return r;
 }
 
-static Tempest::Matrix4x4 mkMatrix(float x,float y,float z,float w,
-                                   float px,float py,float pz) {
-  float m[4][4]={};
-
+static void mkMatrix(float (&m)[4][4], float x,float y,float z,float w,
+                     float px,float py,float pz) {
   m[0][0] = w * w + x * x - y * y - z * z;
   m[0][1] = 2.0f * (x * y - w * z);
   m[0][2] = 2.0f * (x * z + w * y);
@@ -35,11 +41,153 @@ static Tempest::Matrix4x4 mkMatrix(float x,float y,float z,float w,
   m[3][1] = py;
   m[3][2] = pz;
   m[3][3] = 1;
+  }
 
-  return Tempest::Matrix4x4(reinterpret_cast<float*>(m));
+static void mkMatrix(float (&m)[4][4], const phoenix::animation_sample& s) {
+  mkMatrix(m,s.rotation.x,s.rotation.y,s.rotation.z,s.rotation.w,
+           s.position.x,s.position.y,s.position.z);
+  }
+
+// column-major: column j of result is linear combination of columns of 'a'
+static void mul(float* out, const float* a, const float* b) {
+#if defined(ANIM_SSE)
+  const __m128 a0 = _mm_loadu_ps(a+0);
+  const __m128 a1 = _mm_loadu_ps(a+4);
+  const __m128 a2 = _mm_loadu_ps(a+8);
+  const __m128 a3 = _mm_loadu_ps(a+12);
+  for(int j=0; j<4; ++j) {
+    const float* bj = b+j*4;
+    __m128 r = _mm_mul_ps(a0,_mm_set1_ps(bj[0]));
+    r = _mm_add_ps(r,_mm_mul_ps(a1,_mm_set1_ps(bj[1])));
+    r = _mm_add_ps(r,_mm_mul_ps(a2,_mm_set1_ps(bj[2])));
+    r = _mm_add_ps(r,_mm_mul_ps(a3,_mm_set1_ps(bj[3])));
+    _mm_storeu_ps(out+j*4,r);
+    }
+#elif defined(ANIM_NEON)
+  const float32x4_t a0 = vld1q_f32(a+0);
+  const float32x4_t a1 = vld1q_f32(a+4);
+  const float32x4_t a2 = vld1q_f32(a+8);
+  const float32x4_t a3 = vld1q_f32(a+12);
+  for(int j=0; j<4; ++j) {
+    const float* bj = b+j*4;
+    float32x4_t r = vmulq_n_f32(a0,bj[0]);
+    r = vmlaq_n_f32(r,a1,bj[1]);
+    r = vmlaq_n_f32(r,a2,bj[2]);
+    r = vmlaq_n_f32(r,a3,bj[3]);
+    vst1q_f32(out+j*4,r);
+    }
+#else
+  for(int j=0; j<4; ++j)
+    for(int i=0; i<4; ++i)
+      out[j*4+i] = a[i]*b[j*4] + a[4+i]*b[j*4+1] + a[8+i]*b[j*4+2] + a[12+i]*b[j*4+3];
+#endif
   }
 
 Tempest::Matrix4x4 mkMatrix(const phoenix::animation_sample& s) {
-  return mkMatrix(s.rotation.x,s.rotation.y,s.rotation.z,s.rotation.w,
-                  s.position.x,s.position.y,s.position.z);
+  float m[4][4]={};
+  mkMatrix(m,s);
+  return Tempest::Matrix4x4(reinterpret_cast<float*>(m));
+  }
+
+#if defined(ANIM_SSE) || defined(ANIM_NEON)
+// structure-of-arrays: lane k holds sample s[k]
+static void mkMatrix4(Tempest::Matrix4x4* const* out, const phoenix::animation_sample* const* s) {
+  float q[7][4];
+  for(int k=0; k<4; ++k) {
+    q[0][k] = s[k]->rotation.x;
+    q[1][k] = s[k]->rotation.y;
+    q[2][k] = s[k]->rotation.z;
+    q[3][k] = s[k]->rotation.w;
+    q[4][k] = s[k]->position.x;
+    q[5][k] = s[k]->position.y;
+    q[6][k] = s[k]->position.z;
+    }
+#if defined(ANIM_SSE)
+  const __m128 x = _mm_loadu_ps(q[0]), y = _mm_loadu_ps(q[1]);
+  const __m128 z = _mm_loadu_ps(q[2]), w = _mm_loadu_ps(q[3]);
+  const __m128 two  = _mm_set1_ps(2.f);
+  const __m128 zero = _mm_setzero_ps();
+
+  const __m128 ww = _mm_mul_ps(w,w), xx = _mm_mul_ps(x,x);
+  const __m128 yy = _mm_mul_ps(y,y), zz = _mm_mul_ps(z,z);
+  const __m128 xy = _mm_mul_ps(x,y), xz = _mm_mul_ps(x,z), yz = _mm_mul_ps(y,z);
+  const __m128 wx = _mm_mul_ps(w,x), wy = _mm_mul_ps(w,y), wz = _mm_mul_ps(w,z);
+
+  __m128 r[4][4];
+  r[0][0] = _mm_sub_ps(_mm_add_ps(ww,xx),_mm_add_ps(yy,zz));
+  r[0][1] = _mm_mul_ps(two,_mm_sub_ps(xy,wz));
+  r[0][2] = _mm_mul_ps(two,_mm_add_ps(xz,wy));
+  r[0][3] = zero;
+  r[1][0] = _mm_mul_ps(two,_mm_add_ps(xy,wz));
+  r[1][1] = _mm_sub_ps(_mm_add_ps(ww,yy),_mm_add_ps(xx,zz));
+  r[1][2] = _mm_mul_ps(two,_mm_sub_ps(yz,wx));
+  r[1][3] = zero;
+  r[2][0] = _mm_mul_ps(two,_mm_sub_ps(xz,wy));
+  r[2][1] = _mm_mul_ps(two,_mm_add_ps(yz,wx));
+  r[2][2] = _mm_sub_ps(_mm_add_ps(ww,zz),_mm_add_ps(xx,yy));
+  r[2][3] = zero;
+  r[3][0] = _mm_loadu_ps(q[4]);
+  r[3][1] = _mm_loadu_ps(q[5]);
+  r[3][2] = _mm_loadu_ps(q[6]);
+  r[3][3] = _mm_set1_ps(1.f);
+
+  for(int i=0; i<4; ++i) {
+    _MM_TRANSPOSE4_PS(r[i][0],r[i][1],r[i][2],r[i][3]);
+    for(int k=0; k<4; ++k)
+      _mm_storeu_ps(reinterpret_cast<float*>(out[k])+i*4,r[i][k]);
+    }
+#else
+  const float32x4_t x = vld1q_f32(q[0]), y = vld1q_f32(q[1]);
+  const float32x4_t z = vld1q_f32(q[2]), w = vld1q_f32(q[3]);
+  const float32x4_t zero = vdupq_n_f32(0.f);
+
+  const float32x4_t ww = vmulq_f32(w,w), xx = vmulq_f32(x,x);
+  const float32x4_t yy = vmulq_f32(y,y), zz = vmulq_f32(z,z);
+  const float32x4_t xy = vmulq_f32(x,y), xz = vmulq_f32(x,z), yz = vmulq_f32(y,z);
+  const float32x4_t wx = vmulq_f32(w,x), wy = vmulq_f32(w,y), wz = vmulq_f32(w,z);
+
+  float32x4x4_t r[4];
+  r[0].val[0] = vsubq_f32(vaddq_f32(ww,xx),vaddq_f32(yy,zz));
+  r[0].val[1] = vmulq_n_f32(vsubq_f32(xy,wz),2.f);
+  r[0].val[2] = vmulq_n_f32(vaddq_f32(xz,wy),2.f);
+  r[0].val[3] = zero;
+  r[1].val[0] = vmulq_n_f32(vaddq_f32(xy,wz),2.f);
+  r[1].val[1] = vsubq_f32(vaddq_f32(ww,yy),vaddq_f32(xx,zz));
+  r[1].val[2] = vmulq_n_f32(vsubq_f32(yz,wx),2.f);
+  r[1].val[3] = zero;
+  r[2].val[0] = vmulq_n_f32(vsubq_f32(xz,wy),2.f);
+  r[2].val[1] = vmulq_n_f32(vaddq_f32(yz,wx),2.f);
+  r[2].val[2] = vsubq_f32(vaddq_f32(ww,zz),vaddq_f32(xx,yy));
+  r[2].val[3] = zero;
+  r[3].val[0] = vld1q_f32(q[4]);
+  r[3].val[1] = vld1q_f32(q[5]);
+  r[3].val[2] = vld1q_f32(q[6]);
+  r[3].val[3] = vdupq_n_f32(1.f);
+
+  for(int i=0; i<4; ++i) {
+    // interleaved store: row 'i' of lane k goes to tmp[k*4 .. k*4+3]
+    float tmp[16];
+    vst4q_f32(tmp,r[i]);
+    for(int k=0; k<4; ++k)
+      vst1q_f32(reinterpret_cast<float*>(out[k])+i*4,vld1q_f32(tmp+k*4));
+    }
+#endif
+  }
+#endif
+
+void mkMatrices(Tempest::Matrix4x4* const* out, const phoenix::animation_sample* const* s, size_t n) {
+  size_t i = 0;
+#if defined(ANIM_SSE) || defined(ANIM_NEON)
+  for(; i+4<=n; i+=4)
+    mkMatrix4(out+i,s+i);
+#endif
+  for(; i<n; ++i) {
+    float m[4][4]={};
+    mkMatrix(m,*s[i]);
+    *out[i] = Tempest::Matrix4x4(reinterpret_cast<float*>(m));
+    }
+  }
+
+void mulMatrix(Tempest::Matrix4x4& out, const Tempest::Matrix4x4& parent, const Tempest::Matrix4x4& m) {
+  mul(reinterpret_cast<float*>(&out),reinterpret_cast<const float*>(&parent),reinterpret_cast<const float*>(&m));
   }
@@ -7,3 +7,8 @@
 
 phoenix::animation_sample mix(const phoenix::animation_sample& x,const phoenix::animation_sample& y,float a);
 Tempest::Matrix4x4        mkMatrix(const phoenix::animation_sample& s);
+
+// *out[i] = mkMatrix(*s[i]); SIMD path converts 4 samples per iteration
+void                      mkMatrices(Tempest::Matrix4x4* const* out, const phoenix::animation_sample* const* s, size_t n);
+// out = parent * m; 'out' must not alias inputs
+void                      mulMatrix(Tempest::Matrix4x4& out, const Tempest::Matrix4x4& parent, const Tempest::Matrix4x4& m);
@@ -11,9 +11,13 @@
 #include "animmath.h"
 
 #include <cmath>
+#include <atomic>
+#include <algorithm>
 
 using namespace Tempest;
 
+static std::atomic_uint32_t lodFull{0}, lodSkipped{0};
+
 Pose::Pose() {
   lay.reserve(4);
   }
@@ -93,6 +97,7 @@ void Pose::load(Serialize &fin, const AnimationSolver& solver) {
     onAddLayer(i);
   fin.read(headRotX,headRotY);
   needToUpdate = true;
+  lodValid     = false;
 
   numBones = skeleton==nullptr ? 0 : skeleton->nodes.size();
   for(auto& i:hasSamples)
@@ -139,6 +144,7 @@ void Pose::setSkeleton(const Skeleton* sk) {
     i = S_None;
   trY          = skeleton->rootTr.y;
   needToUpdate = true;
+  lodValid     = false;
   if(lay.size()>0) //TODO
     Log::d("WARNING: ",__func__," animation adjustment is not implemented");
   lay.clear();
@@ -297,42 +303,95 @@ void Pose::processLayers(AnimationSolver& solver, uint64_t tickCount) {
     }
   }
 
-bool Pose::update(uint64_t tickCount) {
+Pose::LodStat Pose::lodStat() {
+  LodStat st;
+  st.full    = lodFull.load();
+  st.skipped = lodSkipped.load();
+  return st;
+  }
+
+void Pose::resetLodStat() {
+  lodFull    = 0;
+  lodSkipped = 0;
+  }
+
+bool Pose::update(uint64_t tickCount, const Lod& lod) {
   if(lay.size()==0) {
-    const bool ret = needToUpdate;
-    if(needToUpdate || lastUpdate==0)
+    const bool ret = needToUpdate || objMoved;
+    if(ret || lastUpdate==0)
       mkSkeleton(pos);
     needToUpdate = false;
+    objMoved     = false;
     lastUpdate   = tickCount;
     return ret;
     }
 
   if(lastUpdate!=tickCount) {
-    for(auto& i:lay) {
-      const Animation::Sequence* seq = i.seq;
-      if(0<i.comb && i.comb<=i.seq->comb.size()) {
-        if(auto sx = i.seq->comb[size_t(i.comb-1)])
-          seq = sx;
+    const uint64_t interval = lod.sampleInterval;
+    if(lod.hidden) {
+      // body is not in view: only follow object matrix; sample as soon as visible again
+      lodValid   = false;
+      lastSample = 0;
+      lodSkipped.fetch_add(1,std::memory_order_relaxed);
+      }
+    else if(needToUpdate || interval==0 || tickCount>=lastSample+interval) {
+      // layer changes are always sampled and not blended
+      const bool blend = lod.interpolate && lodValid && !needToUpdate && tickCount<lastSample+2*interval;
+      if(lodValid) {
+        // 'base' holds blended pose - restore the actual sample
+        std::copy(lodTo,lodTo+numBones,base);
+        }
+      sampleLayers(tickCount);
+      if(lod.interpolate) {
+        // displayed pose lags one interval behind: blend from previous sample to this one
+        auto* from = blend ? lodTo : base;
+        std::copy(from,from+numBones,lodFrom);
+        std::copy(base,base+numBones,lodTo);
+        std::copy(lodFrom,lodFrom+numBones,base);
         }
-      needToUpdate |= updateFrame(*seq,i.bs,lastUpdate,i.sAnim,tickCount);
+      lodValid   = lod.interpolate;
+      lastSample = tickCount;
+      lodFull.fetch_add(1,std::memory_order_relaxed);
+      }
+    else if(lodValid) {
+      const float a = std::min(1.f,float(tickCount-lastSample)/float(interval));
+      for(size_t i=0; i<numBones; ++i)
+        base[i] = mix(lodFrom[i],lodTo[i],a);
+      needToUpdate = true;
+      lodSkipped.fetch_add(1,std::memory_order_relaxed);
+      }
+    else {
+      lodSkipped.fetch_add(1,std::memory_order_relaxed);
       }
     lastUpdate = tickCount;
     }
 
-  if(needToUpdate) {
+  if(needToUpdate || objMoved) {
     mkSkeleton(pos);
     needToUpdate = false;
+    objMoved     = false;
     return true;
     }
   return false;
   }
 
+void Pose::sampleLayers(uint64_t tickCount) {
+  for(auto& i:lay) {
+    const Animation::Sequence* seq = i.seq;
+    if(0<i.comb && i.comb<=i.seq->comb.size()) {
+      if(auto sx = i.seq->comb[size_t(i.comb-1)])
+        seq = sx;
+      }
+    needToUpdate |= updateFrame(*seq,i.bs,lastUpdate,i.sAnim,tickCount);
+    }
+  }
+
 bool Pose::updateFrame(const Animation::Sequence &s, BodyState bs,
                        uint64_t barrier, uint64_t sTime, uint64_t now) {
   auto&        d         = *s.data;
   const size_t numFrames = d.numFrames;
   const size_t idSize    = d.nodeIndex.size();
-  if(numFrames==0 || idSize==0 || d.samples.size()%idSize!=0)
+  if(numFrames==0 || idSize==0 || d.samples.size()<numFrames*idSize)
     return false;
   if(numFrames==1 && !needToUpdate)
     return false;
@@ -360,14 +419,14 @@ bool Pose::updateFrame(const Animation::Sequence &s, BodyState bs,
     frameB = d.numFrames-1-frameB;
     }
 
-  auto* sampleA = &d.samples[size_t(frameA*idSize)];
-  auto* sampleB = &d.samples[size_t(frameB*idSize)];
+  const size_t sampleA = size_t(frameA*idSize);
+  const size_t sampleB = size_t(frameB*idSize);
 
   for(size_t i=0; i<idSize; ++i) {
     size_t idx = d.nodeIndex[i];
     if(idx>=numBones)
       continue;
-    auto smp = mix(sampleA[i],sampleB[i],a);
+    auto smp = mix(d.sample(sampleA+i),d.sample(sampleB+i),a);
     if(i==0) {
       if(bs==BS_CLIMB)
         smp.position.y = trY;
@@ -403,25 +462,34 @@ void Pose::mkSkeleton(const Tempest::Matrix4x4& mt) {
     return;
   Matrix4x4 m = mt;
   m.translate(mkBaseTranslation());
-  if(skeleton->ordered)
-    implMkSkeleton(m); else
-    implMkSkeleton(m,size_t(-1));
+  implMkSkeleton(m);
   }
 
 void Pose::implMkSkeleton(const Matrix4x4 &mt) {
-  if(skeleton==nullptr)
-    return;
   auto& nodes      = skeleton->nodes;
   auto  BIP01_HEAD = skeleton->BIP01_HEAD;
+
+  // local transforms of sampled bones, converted in batches
+  Matrix4x4                        local[Resources::MAX_NUM_SKELETAL_NODES];
+  Matrix4x4*                       dst  [Resources::MAX_NUM_SKELETAL_NODES];
+  const phoenix::animation_sample* src  [Resources::MAX_NUM_SKELETAL_NODES];
+  size_t                           cnt = 0;
   for(size_t i=0; i<nodes.size(); ++i) {
-    size_t parent = nodes[i].parent;
-    auto   mat    = hasSamples[i] ? mkMatrix(base[i]) : nodes[i].tr;
+    if(!hasSamples[i])
+      continue;
+    dst[cnt] = &local[i];
+    src[cnt] = &base[i];
+    ++cnt;
+    }
+  mkMatrices(dst,src,cnt);
 
-    if(parent<Resources::MAX_NUM_SKELETAL_NODES)
-      tr[i] = tr[parent]*mat; else
-      tr[i] = mt*mat;
+  for(auto i:skeleton->order) {
+    size_t parent = nodes[i].parent;
+    auto&  pm     = parent<Resources::MAX_NUM_SKELETAL_NODES ? tr[parent] : mt;
+    mulMatrix(tr[i],pm,hasSamples[i] ? local[i] : nodes[i].tr);
 
-    if(i==BIP01_HEAD && (headRotX!=0 || headRotY!=0)) {
+    // head look-at is applied for ordered skeletons only
+    if(skeleton->ordered && i==BIP01_HEAD && (headRotX!=0 || headRotY!=0)) {
       Matrix4x4& m = tr[i];
       m.rotateOY(headRotY);
       m.rotateOX(headRotX);
@@ -429,19 +497,6 @@ void Pose::implMkSkeleton(const Matrix4x4 &mt) {
     }
   }
 
-void Pose::implMkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent) {
-  if(skeleton==nullptr)
-    return;
-  auto& nodes = skeleton->nodes;
-  for(size_t i=0;i<nodes.size();++i){
-    if(nodes[i].parent!=parent)
-      continue;
-    auto mat = hasSamples[i] ? mkMatrix(base[i]) : nodes[i].tr;
-    tr[i] = mt*mat;
-    implMkSkeleton(tr[i],i);
-    }
-  }
-
 const Animation::Sequence* Pose::solveNext(const AnimationSolver &solver, const Layer& lay) {
   auto sq = lay.seq;
 
@@ -554,7 +609,7 @@ void Pose::setObjectMatrix(const Tempest::Matrix4x4& obj, bool sync) {
   pos = obj;
   if(sync)
     mkSkeleton(pos); else
-    needToUpdate = true;
+    objMoved = true;
   }
 
 Tempest::Vec3 Pose::animMoveSpeed(uint64_t tickCount, uint64_t dt) const {
@@ -28,6 +28,21 @@ class Pose final {
       Force      = 0x1,
       };
 
+    // debug counters of animation LOD: sampled and skipped pose updates
+    struct LodStat {
+      uint32_t full    = 0;
+      uint32_t skipped = 0;
+      };
+    static LodStat     lodStat();
+    static void        resetLodStat();
+
+    // animation LOD: far poses are sampled once per 'sampleInterval'; hidden poses are not sampled at all
+    struct Lod {
+      uint64_t sampleInterval = 0;
+      bool     interpolate    = false; // blend between last two samples
+      bool     hidden         = false;
+      };
+
     static uint8_t     calcAniComb(const Tempest::Vec3& dpos, float rotation);
     static uint8_t     calcAniCombVert(const Tempest::Vec3& dpos);
 
@@ -47,7 +62,7 @@ class Pose final {
     void               stopAllAnim();
 
     void               setObjectMatrix(const Tempest::Matrix4x4& obj, bool sync);
-    bool               update(uint64_t tickCount);
+    bool               update(uint64_t tickCount, const Lod& lod = Lod());
 
     void               processLayers(AnimationSolver &solver, uint64_t tickCount);
     bool               processEvents(uint64_t& barrier, uint64_t now, Animation::EvCount &ev) const;
@@ -111,9 +126,9 @@ class Pose final {
     auto mkBaseTranslation() -> Tempest::Vec3;
     void mkSkeleton(const Tempest::Matrix4x4 &mt);
     void implMkSkeleton(const Tempest::Matrix4x4 &mt);
-    void implMkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent);
 
     bool updateFrame(const Animation::Sequence &s, BodyState bs, uint64_t barrier, uint64_t sTime, uint64_t now);
+    void sampleLayers(uint64_t tickCount);
 
     const Animation::Sequence* solveNext(const AnimationSolver& solver, const Layer& lay);
 
@@ -134,8 +149,11 @@ class Pose final {
     float                           trY=0;
     Flags                           flag=NoFlags;
     uint64_t                        lastUpdate=0;
+    uint64_t                        lastSample=0;
     ComboState                      combo;
     bool                            needToUpdate = true;
+    bool                            objMoved     = false;
+    bool                            lodValid     = false;
     uint8_t                         hasEvents = 0;
     uint8_t                         isFlyCombined = 0;
     uint8_t                         hasTransitions = 0;
@@ -146,6 +164,8 @@ class Pose final {
     SampleStatus                    hasSamples[Resources::MAX_NUM_SKELETAL_NODES] = {};
     phoenix::animation_sample       base      [Resources::MAX_NUM_SKELETAL_NODES] = {};
     phoenix::animation_sample       prev      [Resources::MAX_NUM_SKELETAL_NODES] = {};
+    phoenix::animation_sample       lodFrom   [Resources::MAX_NUM_SKELETAL_NODES] = {};
+    phoenix::animation_sample       lodTo     [Resources::MAX_NUM_SKELETAL_NODES] = {};
     Tempest::Matrix4x4              tr        [Resources::MAX_NUM_SKELETAL_NODES] = {};
     Tempest::Matrix4x4              pos;
   };
@@ -38,6 +38,18 @@ Skeleton::Skeleton(const phoenix::model_hierarchy& src, const Animation* anim, s
     if(nodes[i].parent==size_t(-1))
       rootNodes.push_back(i);
 
+  order.reserve(nodes.size());
+  if(ordered) {
+    for(size_t i=0;i<nodes.size();++i)
+      order.push_back(i);
+    } else {
+    order = rootNodes;
+    for(size_t i=0; i<order.size(); ++i)
+      for(size_t r=0; r<nodes.size(); ++r)
+        if(nodes[r].parent==order[i])
+          order.push_back(r);
+    }
+
   auto tr = src.root_translation;
   rootTr = Vec3{tr.x,tr.y,tr.z};
 
@@ -22,6 +22,7 @@ class Skeleton final {
     bool                            ordered=true;
     std::vector<Node>               nodes;
     std::vector<size_t>             rootNodes;
+    std::vector<size_t>             order; // parents go before children
     std::vector<Tempest::Matrix4x4> tr;
     Tempest::Vec3                   rootTr={};
 
@@ -1,12 +1,21 @@
 #include "packedmesh.h"
 
 #include <Tempest/Application>
+#include <Tempest/File>
+#include <Tempest/TextCodec>
 #include <Tempest/Log>
 #include <fstream>
 #include <algorithm>
+#include <filesystem>
 #include <unordered_set>
+#include <cstring>
+#include <cstdio>
+#include <random>
+#include <thread>
 
 #include "game/compatibility/phoenix.h"
+#include "utils/fileutil.h"
+#include "utils/workers.h"
 #include "gothic.h"
 
 using namespace Tempest;
@@ -386,6 +395,29 @@ PackedMesh::PackedMesh(const phoenix::softskin_mesh& skinned) {
   packMeshletsObj(mesh,PK_Visual,&vertices);
   }
 
+PackedMesh::PackedMesh(const phoenix::proto_mesh& mesh, PkgType type, std::string_view cacheName) {
+  auto path = Resources::meshCachePath(cacheName,uint8_t(type));
+  if(loadCache(path,type,mesh.sub_meshes.size())) {
+    for(size_t i=0; i<subMeshes.size(); ++i)
+      subMeshes[i].material = mesh.sub_meshes[materialId[i]].mat;
+    return;
+    }
+  *this = PackedMesh(mesh,type);
+  saveCache(path,type);
+  }
+
+PackedMesh::PackedMesh(const phoenix::mesh& mesh, PkgType type, std::string_view cacheName) {
+  auto path = Resources::meshCachePath(cacheName,uint8_t(type));
+  if(type!=PK_Physic && loadCache(path,type,mesh.materials.size())) {
+    for(size_t i=0; i<subMeshes.size(); ++i)
+      subMeshes[i].material = mesh.materials[materialId[i]];
+    return;
+    }
+  *this = PackedMesh(mesh,type);
+  if(type!=PK_Physic)
+    saveCache(path,type);
+  }
+
 void PackedMesh::packPhysics(const phoenix::mesh& mesh, PkgType type) {
   auto& vbo = mesh.vertices;
   auto& ibo = mesh.polygons.vertex_indices;
@@ -480,20 +512,186 @@ void PackedMesh::packPhysics(const phoenix::mesh& mesh, PkgType type) {
     }
   }
 
+namespace {
+struct CacheHeader {
+  char     magic[4]   = {'P','K','M','H'};
+  uint32_t version    = 0;
+  uint64_t stamp      = 0;
+  uint8_t  type       = 0;
+  uint8_t  meshShader = 0;
+  uint8_t  alphaTest  = 0;
+  uint8_t  padd       = 0;
+  uint32_t subMeshes  = 0;
+  uint64_t size[6]    = {};
+  float    bbox[6]    = {};
+  };
+
+struct CacheSubMesh {
+  uint32_t material  = 0;
+  uint32_t padd      = 0;
+  uint64_t iboOffset = 0;
+  uint64_t iboLength = 0;
+  };
+}
+
+template<class T>
+static bool readCache(Tempest::IDevice& fin, std::vector<T>& v, uint64_t sz) {
+  if(sz*sizeof(T)>fin.size())
+    return false;
+  v.resize(size_t(sz));
+  const size_t bytes = v.size()*sizeof(T);
+  return fin.read(v.data(),bytes)==bytes;
+  }
+
+template<class T>
+static void writeCache(Tempest::ODevice& fout, const std::vector<T>& v) {
+  fout.write(v.data(),v.size()*sizeof(T));
+  }
+
+bool PackedMesh::loadCache(const std::u16string& path, PkgType type, size_t matCount) {
+  if(path.empty() || !FileUtil::exists(path))
+    return false;
+
+  try {
+    Tempest::RFile fin(path);
+    CacheHeader    ref, hdr;
+    if(fin.read(&hdr,sizeof(hdr))!=sizeof(hdr))
+      return false;
+    if(std::memcmp(hdr.magic,ref.magic,sizeof(ref.magic))!=0 || hdr.version!=CacheVersion ||
+       hdr.stamp!=Resources::vdfsStamp() || hdr.type!=uint8_t(type) ||
+       hdr.meshShader!=uint8_t(Gothic::inst().doMeshShading() ? 1 : 0))
+      return false;
+
+    std::vector<CacheSubMesh> sub;
+    if(!readCache(fin,sub,hdr.subMeshes)        ||
+       !readCache(fin,vertices,     hdr.size[0]) ||
+       !readCache(fin,verticesA,    hdr.size[1]) ||
+       !readCache(fin,indices,      hdr.size[2]) ||
+       !readCache(fin,indices8,     hdr.size[3]) ||
+       !readCache(fin,meshletBounds,hdr.size[4]) ||
+       !readCache(fin,verticesId,   hdr.size[5]))
+      return false;
+
+    subMeshes .resize(sub.size());
+    materialId.resize(sub.size());
+    for(size_t i=0; i<sub.size(); ++i) {
+      if(sub[i].material>=matCount || sub[i].iboOffset+sub[i].iboLength>indices.size())
+        return false;
+      materialId[i]          = sub[i].material;
+      subMeshes[i].iboOffset = size_t(sub[i].iboOffset);
+      subMeshes[i].iboLength = size_t(sub[i].iboLength);
+      }
+    isUsingAlphaTest = (hdr.alphaTest!=0);
+    mBbox[0] = Vec3(hdr.bbox[0],hdr.bbox[1],hdr.bbox[2]);
+    mBbox[1] = Vec3(hdr.bbox[3],hdr.bbox[4],hdr.bbox[5]);
+    return true;
+    }
+  catch(...) {
+    return false;
+    }
+  }
+
+void PackedMesh::saveCache(const std::u16string& path, PkgType type) const {
+  if(path.empty())
+    return;
+
+  CacheHeader hdr;
+  hdr.version    = CacheVersion;
+  hdr.stamp      = Resources::vdfsStamp();
+  hdr.type       = uint8_t(type);
+  hdr.meshShader = uint8_t(Gothic::inst().doMeshShading() ? 1 : 0);
+  hdr.alphaTest  = uint8_t(isUsingAlphaTest ? 1 : 0);
+  hdr.subMeshes  = uint32_t(subMeshes.size());
+  hdr.size[0]    = vertices.size();
+  hdr.size[1]    = verticesA.size();
+  hdr.size[2]    = indices.size();
+  hdr.size[3]    = indices8.size();
+  hdr.size[4]    = meshletBounds.size();
+  hdr.size[5]    = verticesId.size();
+  hdr.bbox[0]    = mBbox[0].x;
+  hdr.bbox[1]    = mBbox[0].y;
+  hdr.bbox[2]    = mBbox[0].z;
+  hdr.bbox[3]    = mBbox[1].x;
+  hdr.bbox[4]    = mBbox[1].y;
+  hdr.bbox[5]    = mBbox[1].z;
+
+  std::vector<CacheSubMesh> sub(subMeshes.size());
+  for(size_t i=0; i<sub.size(); ++i) {
+    sub[i].material  = materialId[i];
+    sub[i].iboOffset = subMeshes[i].iboOffset;
+    sub[i].iboLength = subMeshes[i].iboLength;
+    }
+
+  // write to temporary file first: cache can be shared by multiple game instances and loader threads
+  std::u16string tmp;
+  try {
+    std::random_device rd;
+    const uint64_t salt = ((uint64_t(rd())<<32) | uint64_t(rd())) ^ uint64_t(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    char suffix[32] = {};
+    std::snprintf(suffix,sizeof(suffix),".%016llx.tmp",static_cast<unsigned long long>(salt));
+    tmp = path + TextCodec::toUtf16(std::string(suffix));
+    {
+      Tempest::WFile fout(tmp);
+      fout.write(&hdr,sizeof(hdr));
+      writeCache(fout,sub);
+      writeCache(fout,vertices);
+      writeCache(fout,verticesA);
+      writeCache(fout,indices);
+      writeCache(fout,indices8);
+      writeCache(fout,meshletBounds);
+      writeCache(fout,verticesId);
+    }
+    std::filesystem::rename(std::filesystem::path(tmp),std::filesystem::path(path));
+    }
+  catch(...) {
+    Log::e("unable to write mesh cache: \"",TextCodec::toUtf8(path),"\"");
+    std::error_code ec;
+    if(!tmp.empty())
+      std::filesystem::remove(std::filesystem::path(tmp),ec);
+    }
+  }
+
 void PackedMesh::packMeshletsLnd(const phoenix::mesh& mesh) {
   auto& ibo  = mesh.polygons.vertex_indices;
   auto& feat = mesh.polygons.feature_indices;
   auto& mat  = mesh.polygons.material_indices;
 
-  PrimitiveHeap heap;
-  heap.reserve(ibo.size()/3);
-  std::vector<bool> used(ibo.size()/3,false);
+  const size_t triCount = ibo.size()/3;
+  const size_t matCount = mesh.materials.size();
 
-  for(size_t mId=0; mId<mesh.materials.size(); ++mId) {
-    heap.clear();
-    for(size_t id=0; id<ibo.size(); id+=3) {
-      if(size_t(mat[id/3u])!=mId)
-        continue;
+  // triangles, grouped by material; keeps original order within material
+  std::vector<size_t> triOffset(matCount+1,0);
+  std::vector<size_t> triList(triCount);
+  for(size_t i=0; i<triCount; ++i) {
+    auto mId = size_t(mat[i]);
+    if(mId<matCount)
+      triOffset[mId+1]++;
+    }
+  for(size_t i=0; i<matCount; ++i)
+    triOffset[i+1] += triOffset[i];
+  {
+    auto at = triOffset;
+    for(size_t i=0; i<triCount; ++i) {
+      auto mId = size_t(mat[i]);
+      if(mId<matCount)
+        triList[at[mId]++] = i;
+      }
+  }
+
+  // materials are independent - output is same as with serial packing
+  // triangle sets of materials are disjoint: tasks share one 'used' array (bytes, to not race on bits)
+  std::vector<std::vector<Meshlet>> meshlets(matCount);
+  std::vector<uint8_t>              used(triCount,0);
+  auto build = [&](size_t mId) {
+    const size_t first = triOffset[mId];
+    const size_t last  = triOffset[mId+1];
+    if(first==last)
+      return;
+
+    PrimitiveHeap heap;
+    heap.reserve(last-first);
+    for(size_t i=first; i<last; ++i) {
+      const size_t id = triList[i]*3;
       auto a = mkUInt64(ibo[id+0],feat[id+0]);
       auto b = mkUInt64(ibo[id+1],feat[id+1]);
       auto c = mkUInt64(ibo[id+2],feat[id+2]);
@@ -503,23 +701,34 @@ void PackedMesh::packMeshletsLnd(const phoenix::mesh& mesh) {
       heap.push_back(std::make_pair(c, id));
       }
 
-    if(heap.size()==0)
-      continue;
+    auto& ret = meshlets[mId];
+    ret = buildMeshlets(&mesh,nullptr,heap,used);
+    for(auto& i:ret)
+      i.updateBounds(mesh);
+    };
 
-    std::vector<Meshlet> meshlets = buildMeshlets(&mesh,nullptr,heap,used);
-    for(size_t i=0; i<meshlets.size(); ++i)
-      meshlets[i].updateBounds(mesh);
+  if(triCount>=ParallelTriCount) {
+    Workers::parallelTasks(matCount,[&](size_t mId){ build(mId); });
+    } else {
+    for(size_t mId=0; mId<matCount; ++mId)
+      build(mId);
+    }
 
+  for(size_t mId=0; mId<matCount; ++mId) {
+    if(meshlets[mId].empty())
+      continue;
     SubMesh pack;
     pack.material  = mesh.materials[mId];
     pack.iboOffset = indices.size();
-    for(auto& i:meshlets)
+    for(auto& i:meshlets[mId])
       i.flush(vertices,indices,indices8,meshletBounds,mesh);
     pack.iboLength = indices.size() - pack.iboOffset;
-    if(pack.iboLength>0)
+    if(pack.iboLength>0) {
       subMeshes.push_back(std::move(pack));
+      materialId.push_back(uint32_t(mId));
+      }
 
-    //dbgUtilization(meshlets);
+    //dbgUtilization(meshlets[mId]);
     }
   }
 
@@ -532,7 +741,11 @@ void PackedMesh::packMeshletsObj(const phoenix::proto_mesh& mesh, PkgType type,
     maxTri = std::max(maxTri, sm.triangles.size());
   PrimitiveHeap heap;
   heap.reserve(maxTri);
-  std::vector<bool> used(maxTri);
+  std::vector<uint8_t> used(maxTri);
+
+  materialId.resize(mesh.sub_meshes.size());
+  for(size_t i=0; i<materialId.size(); ++i)
+    materialId[i] = uint32_t(i);
 
   for(size_t mId=0; mId<mesh.sub_meshes.size(); ++mId) {
     auto& sm      = mesh.sub_meshes[mId];
@@ -540,6 +753,7 @@ void PackedMesh::packMeshletsObj(const phoenix::proto_mesh& mesh, PkgType type,
     pack.material = sm.mat;
 
     heap.clear();
+    std::fill(used.begin(), used.begin()+ptrdiff_t(sm.triangles.size()), 0);
     for(size_t i=0; i<sm.triangles.size(); ++i) {
       const uint16_t* ibo = sm.triangles[i].wedges;
       for(int x=0; x<3; ++x) {
@@ -564,9 +778,9 @@ void PackedMesh::packMeshletsObj(const phoenix::proto_mesh& mesh, PkgType type,
 
 std::vector<PackedMesh::Meshlet> PackedMesh::buildMeshlets(const phoenix::mesh* mesh,
                                                            const phoenix::sub_mesh* proto_mesh,
-                                                           PrimitiveHeap& heap, std::vector<bool>& used) {
+                                                           PrimitiveHeap& heap, std::vector<uint8_t>& used) {
+  // 'used' is expected to be clear for triangles in heap
   heap.sort();
-  std::fill(used.begin(), used.end(), false);
 
   size_t  firstUnused = 0;
   size_t  firstVert   = 0;
@@ -58,13 +58,21 @@ class PackedMesh {
     PackedMesh(const phoenix::proto_mesh& mesh, PkgType type);
     PackedMesh(const phoenix::mesh& mesh, PkgType type);
     PackedMesh(const phoenix::softskin_mesh&  mesh);
+    // same as above, but reuses packed data from on-disk cache, if up to date
+    PackedMesh(const phoenix::proto_mesh& mesh, PkgType type, std::string_view cacheName);
+    PackedMesh(const phoenix::mesh& mesh, PkgType type, std::string_view cacheName);
 
     void debug(std::ostream &out) const;
 
     std::pair<Tempest::Vec3,Tempest::Vec3> bbox() const;
 
   private:
-    Tempest::Vec3 mBbox[2];
+    // meshes are packed per material on workers, above this size
+    static constexpr size_t ParallelTriCount = 4096;
+    static constexpr uint32_t CacheVersion   = 1;
+
+    Tempest::Vec3         mBbox[2];
+    std::vector<uint32_t> materialId; // source material of each submesh
 
     struct SkeletalData {
       Tempest::Vec3 localPositions[4] = {};
@@ -110,10 +118,13 @@ class PackedMesh {
                            const std::vector<SkeletalData>* skeletal);
 
     std::vector<Meshlet> buildMeshlets(const phoenix::mesh* mesh, const phoenix::sub_mesh* proto_mesh,
-                                       PrimitiveHeap& heap, std::vector<bool>& used);
+                                       PrimitiveHeap& heap, std::vector<uint8_t>& used);
 
     void   computeBbox();
 
+    bool   loadCache(const std::u16string& path, PkgType type, size_t matCount);
+    void   saveCache(const std::u16string& path, PkgType type) const;
+
     void   dbgUtilization(const std::vector<Meshlet>& meshlets);
     void   dbgMeshlets(const phoenix::mesh& mesh, const std::vector<Meshlet*>& meshlets);
   };
@@ -90,6 +90,14 @@ Bounds MeshObjects::Mesh::bounds() const {
   return b;
   }
 
+bool MeshObjects::Mesh::isVisible() const {
+  // in any view of last frame
+  for(size_t i=0; i<subCount; ++i)
+    if(sub[i].isVisible())
+      return true;
+  return false;
+  }
+
 const PfxEmitterMesh* MeshObjects::Mesh::toMeshEmitter() const {
   if(auto p = proto)
     return Resources::loadEmiterMesh(p->fname);
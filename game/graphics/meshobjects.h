@@ -70,6 +70,7 @@ class MeshObjects final {
         Node   node(size_t i) const { return Node(&sub[i]); }
 
         Bounds bounds() const;
+        bool   isVisible() const;
         const ProtoMesh* protoMesh() const { return proto; }
 
         const PfxEmitterMesh* toMeshEmitter() const;
@@ -112,6 +112,12 @@ const Bounds& ObjectsBucket::Item::bounds() const {
   return b;
   }
 
+bool ObjectsBucket::Item::isVisible() const {
+  if(owner!=nullptr)
+    return owner->isVisible(id);
+  return false;
+  }
+
 Matrix4x4 ObjectsBucket::Item::position() const {
   if(owner!=nullptr)
     return owner->position(id);
@@ -203,6 +209,36 @@ bool ObjectsBucket::isCompatible(const Type t, const Material& mat,
   return this->mat==mat && instanceDesc==desc && staticMesh==st && animMesh==ani;
   }
 
+size_t ObjectsBucket::compatibilityHash(const Type t, const Material& mat,
+                                        const StaticMesh* st, const AnimMesh* ani,
+                                        const Tempest::StorageBuffer* desc) {
+  auto mix = [](size_t h, size_t v) {
+    return h ^ (v + 0x9e3779b9 + (h<<6) + (h>>2));
+    };
+  auto type = sanitizeType(t,mat,st);
+  // must follow isCompatible: fields, not compared there, are not hashed
+  size_t h = mix(0,size_t(type));
+  if(type==Landscape && Gothic::inst().doMeshShading()) {
+    h = mix(h,size_t(mat.alpha));
+    return mix(h,std::uintptr_t(desc));
+    }
+
+  h = mix(h,std::uintptr_t(mat.tex));
+  h = mix(h,size_t(mat.alpha));
+  h = mix(h,size_t(mat.isGhost));
+  if(type==Pfx || type==Landscape || type==LandscapeShadow)
+    return h;
+
+  h = mix(h,std::uintptr_t(desc));
+  h = mix(h,std::uintptr_t(st));
+  h = mix(h,std::uintptr_t(ani));
+  return h;
+  }
+
+size_t ObjectsBucket::compatibilityHash() const {
+  return compatibilityHash(objType,mat,staticMesh,animMesh,instanceDesc);
+  }
+
 std::unique_ptr<ObjectsBucket> ObjectsBucket::mkBucket(Type type, const Material& mat, VisualObjects& owner, const SceneGlobals& scene,
                                                        const StaticMesh* st, const AnimMesh* anim, const StorageBuffer* desc) {
   type = sanitizeType(type,mat,st);
@@ -869,6 +905,10 @@ const Bounds& ObjectsBucket::bounds(size_t i) const {
   return val[i].visibility.bounds();
   }
 
+bool ObjectsBucket::isVisible(size_t i) const {
+  return val[i].visibility.isVisible();
+  }
+
 Matrix4x4 ObjectsBucket::position(size_t i) const {
   return val[i].pos;
   }
@@ -77,6 +77,7 @@ class ObjectsBucket {
 
         const Material&    material() const;
         const Bounds&      bounds()   const;
+        bool               isVisible() const;
         Tempest::Matrix4x4 position() const;
         const StaticMesh*  mesh()     const;
         std::pair<uint32_t,uint32_t> meshSlice() const;
@@ -92,6 +93,10 @@ class ObjectsBucket {
 
     bool isCompatible(const Type type, const Material& mat,
                       const StaticMesh* st, const AnimMesh* ani, const Tempest::StorageBuffer* desc) const;
+    // equal for compatible buckets; used as lookup key by VisualObjects
+    static size_t compatibilityHash(const Type type, const Material& mat,
+                                    const StaticMesh* st, const AnimMesh* ani, const Tempest::StorageBuffer* desc);
+    size_t        compatibilityHash() const;
 
     static std::unique_ptr<ObjectsBucket> mkBucket(Type type, const Material& mat, VisualObjects& owner, const SceneGlobals& scene,
                                                    const StaticMesh* st, const AnimMesh* anim, const Tempest::StorageBuffer* desc);
@@ -234,6 +239,7 @@ class ObjectsBucket {
                                          const Tempest::RenderPipeline& shader, SceneGlobals::VisCamera c, bool isHiZPass);
 
     const Bounds&             bounds(size_t i) const;
+    bool                      isVisible(size_t i) const;
     Tempest::Matrix4x4        position(size_t i) const;
     virtual const Material&   material(size_t i) const;
     std::pair<uint32_t,uint32_t> meshSlice(size_t i) const;
@@ -1,10 +1,20 @@
 #include "pfxbucket.h"
 
 #include "graphics/mesh/submesh/pfxemittermesh.h"
+#include "graphics/dynamic/frustrum.h"
 #include "pfxobjects.h"
 #include "particlefx.h"
 
 #include "world/objects/npc.h"
+#include "utils/workers.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define PFX_SSE 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PFX_NEON 1
+#endif
 
 using namespace Tempest;
 
@@ -23,8 +33,76 @@ static uint64_t ppsDiff(const ParticleFx& decl, bool loop, uint64_t time0, uint6
   return emitted1-emitted0;
   }
 
-float PfxBucket::ParState::lifeTime() const {
-  return 1.f-life/float(maxLife);
+// pos += dir*dt; dir += gravity*dt
+static void integrate(Vec3* pos, Vec3* dir, size_t count, const Vec3& gravity, float dt) {
+  static_assert(sizeof(Vec3)==sizeof(float)*3, "Vec3 is expected to be tightly packed");
+  float*       p  = reinterpret_cast<float*>(pos);
+  float*       d  = reinterpret_cast<float*>(dir);
+  const size_t sz = count*3;
+  const float  g[3] = {gravity.x*dt, gravity.y*dt, gravity.z*dt};
+
+  size_t i = 0;
+#if defined(PFX_SSE)
+  // 4 particles per iteration: gravity pattern repeats every 12 floats
+  const __m128 vdt = _mm_set1_ps(dt);
+  const __m128 g0  = _mm_setr_ps(g[0],g[1],g[2],g[0]);
+  const __m128 g1  = _mm_setr_ps(g[1],g[2],g[0],g[1]);
+  const __m128 g2  = _mm_setr_ps(g[2],g[0],g[1],g[2]);
+  for(; i+12<=sz; i+=12) {
+    __m128 d0 = _mm_loadu_ps(d+i+0);
+    __m128 d1 = _mm_loadu_ps(d+i+4);
+    __m128 d2 = _mm_loadu_ps(d+i+8);
+    _mm_storeu_ps(p+i+0,_mm_add_ps(_mm_loadu_ps(p+i+0),_mm_mul_ps(d0,vdt)));
+    _mm_storeu_ps(p+i+4,_mm_add_ps(_mm_loadu_ps(p+i+4),_mm_mul_ps(d1,vdt)));
+    _mm_storeu_ps(p+i+8,_mm_add_ps(_mm_loadu_ps(p+i+8),_mm_mul_ps(d2,vdt)));
+    _mm_storeu_ps(d+i+0,_mm_add_ps(d0,g0));
+    _mm_storeu_ps(d+i+4,_mm_add_ps(d1,g1));
+    _mm_storeu_ps(d+i+8,_mm_add_ps(d2,g2));
+    }
+#elif defined(PFX_NEON)
+  const float gp[12] = {g[0],g[1],g[2],g[0], g[1],g[2],g[0],g[1], g[2],g[0],g[1],g[2]};
+  const float32x4_t g0 = vld1q_f32(gp+0);
+  const float32x4_t g1 = vld1q_f32(gp+4);
+  const float32x4_t g2 = vld1q_f32(gp+8);
+  for(; i+12<=sz; i+=12) {
+    float32x4_t d0 = vld1q_f32(d+i+0);
+    float32x4_t d1 = vld1q_f32(d+i+4);
+    float32x4_t d2 = vld1q_f32(d+i+8);
+    vst1q_f32(p+i+0,vaddq_f32(vld1q_f32(p+i+0),vmulq_n_f32(d0,dt)));
+    vst1q_f32(p+i+4,vaddq_f32(vld1q_f32(p+i+4),vmulq_n_f32(d1,dt)));
+    vst1q_f32(p+i+8,vaddq_f32(vld1q_f32(p+i+8),vmulq_n_f32(d2,dt)));
+    vst1q_f32(d+i+0,vaddq_f32(d0,g0));
+    vst1q_f32(d+i+4,vaddq_f32(d1,g1));
+    vst1q_f32(d+i+8,vaddq_f32(d2,g2));
+    }
+#endif
+  for(; i<sz; ++i) {
+    p[i] += d[i]*dt;
+    d[i] += g[i%3];
+    }
+  }
+
+void PfxBucket::Particles::resize(size_t sz) {
+  life    .resize(sz,0);
+  maxLife .resize(sz,1);
+  pos     .resize(sz);
+  dir     .resize(sz);
+  trlBegin.resize(sz,0);
+  trlCount.resize(sz,0);
+  trail   .resize(sz*trlCap);
+  }
+
+void PfxBucket::Particles::clear(size_t i) {
+  life    [i] = 0;
+  maxLife [i] = 1;
+  pos     [i] = Vec3();
+  dir     [i] = Vec3();
+  trlBegin[i] = 0;
+  trlCount[i] = 0;
+  }
+
+float PfxBucket::Particles::lifeTime(size_t i) const {
+  return 1.f-life[i]/float(maxLife[i]);
   }
 
 std::mt19937 PfxBucket::rndEngine;
@@ -43,8 +121,18 @@ PfxBucket::PfxBucket(const ParticleFx &decl, PfxObjects& parent, VisualObjects&
   if(blockSize==0)
     blockSize=1;
 
+  // conservative bounds of emitter, for culling
+  const float ltF  = float(lt);
+  const float vel  = decl.velAvg+decl.velVar;
+  const float size = std::max(decl.visSizeStart.x,decl.visSizeStart.y)*std::max(1.f,decl.visSizeEndScale);
+  visRadius = decl.shpDim.length() + decl.shpOffsetVec.length() + vel*ltF +
+              0.5f*decl.flyGravity.length()*ltF*ltF + size + 200.f;
+
   if(decl.hasTrails()) {
     maxTrlTime = uint64_t(decl.trlFadeSpeed*1000.f);
+    // trail points are spaced in time, not per tick: length does not depend on frame rate
+    particles.trlCap = size_t(std::clamp<uint64_t>(maxTrlTime/8+2, 2, 128));
+    trlStep          = std::max<uint64_t>(1, maxTrlTime/(particles.trlCap-1));
 
     Material mat = decl.visMaterial;
     mat.tex = decl.trlTexture;
@@ -72,6 +160,7 @@ size_t PfxBucket::allocBlock() {
     if(!block[i].allocated) {
       block[i].allocated = true;
       block[i].timeTotal = 0;
+      block[i].ticked    = false;
       return i;
       }
     }
@@ -87,7 +176,7 @@ size_t PfxBucket::allocBlock() {
   pfxCpu   .resize(particles.size());
 
   for(size_t i=0; i<blockSize; ++i)
-    particles[b.offset+i].life = 0;
+    particles.clear(b.offset+i);
   return block.size()-1;
   }
 
@@ -181,68 +270,68 @@ float PfxBucket::randf(float base, float var) {
   }
 
 void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t particle) {
-  auto& p   = particles[particle];
+  Vec3 pos, dir;
 
-  p.life    = uint16_t(randf(decl.lspPartAvg,decl.lspPartVar));
-  p.maxLife = p.life;
+  particles.life   [particle] = uint16_t(randf(decl.lspPartAvg,decl.lspPartVar));
+  particles.maxLife[particle] = particles.life[particle];
 
   // TODO: pfx.shpDistribType, pfx.shpDistribWalkSpeed;
   switch(decl.shpType) {
     case ParticleFx::EmitterType::Point:{
-      p.pos = Vec3();
+      pos = Vec3();
       break;
       }
     case ParticleFx::EmitterType::Line:{
       float at = randf();
-      p.pos = Vec3(at,at,at);
+      pos = Vec3(at,at,at);
       break;
       }
     case ParticleFx::EmitterType::Box:{
       if(decl.shpIsVolume) {
-        p.pos = Vec3(randf()*2.f-1.f,
-                     randf()*2.f-1.f,
-                     randf()*2.f-1.f);
-        p.pos*=0.5;
+        pos = Vec3(randf()*2.f-1.f,
+                   randf()*2.f-1.f,
+                   randf()*2.f-1.f);
+        pos*=0.5;
         } else {
         // TODO
-        p.pos = Vec3(randf()*2.f-1.f,
-                     randf()*2.f-1.f,
-                     randf()*2.f-1.f);
-        p.pos*=0.5;
+        pos = Vec3(randf()*2.f-1.f,
+                   randf()*2.f-1.f,
+                   randf()*2.f-1.f);
+        pos*=0.5;
         }
       break;
       }
     case ParticleFx::EmitterType::Sphere:{
       float theta = float(2.0*M_PI)*randf();
       float phi   = std::acos(1.f - 2.f * randf());
-      p.pos = Vec3(std::sin(phi) * std::cos(theta),
-                   std::sin(phi) * std::sin(theta),
-                   std::cos(phi));
-      //p.pos*=0.5;
+      pos = Vec3(std::sin(phi) * std::cos(theta),
+                 std::sin(phi) * std::sin(theta),
+                 std::cos(phi));
+      //pos*=0.5;
       if(decl.shpIsVolume)
-        p.pos*=randf();
+        pos*=randf();
       break;
       }
     case ParticleFx::EmitterType::Circle:{
       float a = float(2.0*M_PI)*randf();
-      p.pos = Vec3(std::sin(a),
-                   0,
-                   std::cos(a));
-      //p.pos*=0.5;
+      pos = Vec3(std::sin(a),
+                 0,
+                 std::cos(a));
+      //pos*=0.5;
       if(decl.shpIsVolume)
-        p.pos = p.pos*std::sqrt(randf());
+        pos = pos*std::sqrt(randf());
       break;
       }
     case ParticleFx::EmitterType::Mesh:{
-      p.pos = Vec3();
+      pos = Vec3();
       auto mesh = (emitter.mesh!=nullptr) ? emitter.mesh : decl.shpMesh;
       auto pose = (emitter.mesh!=nullptr) ? emitter.pose : nullptr;
       if(mesh!=nullptr) {
-        auto pos = mesh->randCoord(randf(),pose);
-        pos -= emitter.pos;
-        p.pos = emitter.direction[0]*pos.x +
-                emitter.direction[1]*pos.y +
-                emitter.direction[2]*pos.z;
+        auto at = mesh->randCoord(randf(),pose);
+        at -= emitter.pos;
+        pos = emitter.direction[0]*at.x +
+              emitter.direction[1]*at.y +
+              emitter.direction[2]*at.z;
         }
       break;
       }
@@ -251,21 +340,21 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
   if(decl.shpType!=ParticleFx::EmitterType::Point &&
      decl.shpType!=ParticleFx::EmitterType::Mesh) {
     Vec3 dim = decl.shpDim*decl.shpScale(block.timeTotal);
-    p.pos.x*=dim.x;
-    p.pos.y*=dim.y;
-    p.pos.z*=dim.z;
+    pos.x*=dim.x;
+    pos.y*=dim.y;
+    pos.z*=dim.z;
     }
 
   switch(decl.shpFOR) {
     case ParticleFx::Frame::Object:
     case ParticleFx::Frame::Node: {
-      p.pos += emitter.direction[0]*decl.shpOffsetVec.x +
-               emitter.direction[1]*decl.shpOffsetVec.y +
-               emitter.direction[2]*decl.shpOffsetVec.z;
+      pos += emitter.direction[0]*decl.shpOffsetVec.x +
+             emitter.direction[1]*decl.shpOffsetVec.y +
+             emitter.direction[2]*decl.shpOffsetVec.z;
       break;
       }
     case ParticleFx::Frame::World: {
-      p.pos += decl.shpOffsetVec;
+      pos += decl.shpOffsetVec;
       break;
       }
     }
@@ -278,7 +367,7 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
       float dx    = sn * std::cos(theta);
       float dz    = sn * std::sin(theta);
 
-      p.dir       = Vec3(dx,dy,dz);
+      dir         = Vec3(dx,dy,dz);
       break;
       }
     case ParticleFx::Dir::Dir: {
@@ -301,13 +390,13 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
       switch(decl.dirFOR) {
         case ParticleFx::Frame::Object:
         case ParticleFx::Frame::Node: {
-          p.dir = emitter.direction[0]*dx +
-                  emitter.direction[1]*dy +
-                  emitter.direction[2]*dz;
+          dir = emitter.direction[0]*dx +
+                emitter.direction[1]*dy +
+                emitter.direction[2]*dz;
           break;
           }
         case ParticleFx::Frame::World: {
-          p.dir = Vec3(dx,dy,dz);
+          dir = Vec3(dx,dy,dz);
           break;
           }
         }
@@ -332,93 +421,198 @@ void PfxBucket::init(PfxBucket::Block& block, ImplEmitter& emitter, size_t parti
           break;
           }
         }
-      p.dir += targetPos - (emitter.pos+p.pos);
+      dir += targetPos - (emitter.pos+pos);
       break;
     }
 
   if(!decl.useEmittersFOR)
-    p.pos += emitter.pos;
+    pos += emitter.pos;
 
-  auto l = p.dir.length();
+  auto l = dir.length();
   if(l!=0.f) {
     float velocity = randf(decl.velAvg,decl.velVar);
-    p.dir = p.dir*velocity/l;
+    dir = dir*velocity/l;
     }
+  particles.pos[particle] = pos;
+  particles.dir[particle] = dir;
   }
 
 void PfxBucket::finalize(size_t particle) {
-  particles[particle] = {};
-  pfxCpu   [particle] = {};
+  particles.clear(particle);
+  pfxCpu[particle] = {};
   }
 
-void PfxBucket::tick(Block& sys, ImplEmitter& emitter, size_t particle, uint64_t dt) {
-  ParState& ps = particles[particle+sys.offset];
-  if(ps.life==0)
-    return;
-
-  if(ps.life<=dt){
-    ps.life = 0;
-    sys.count--;
-    finalize(particle+sys.offset);
-    return;
+void PfxBucket::tickChunk(SimChunk& c, uint64_t dt) {
+  auto&  emitter = impl[c.emitter];
+  size_t died    = 0;
+  for(size_t i=c.begin; i<c.end; ++i) {
+    auto& life = particles.life[i];
+    if(life==0)
+      continue;
+    if(life<=dt) {
+      finalize(i);
+      ++died;
+      continue;
+      }
+    life = uint16_t(life-dt);
     }
+  c.died = died;
 
-  const float dtF = float(dt);
+  // dead particles are integrated too: state is reset by init()
+  integrate(&particles.pos[c.begin],&particles.dir[c.begin],c.end-c.begin,decl.flyGravity,float(dt));
 
-  // eval particle
-  ps.life  = uint16_t(ps.life-dt);
-  ps.pos  += ps.dir*dtF;
-  ps.dir  += decl.flyGravity*dtF;
-
-  if(maxTrlTime!=0)
-    tickTrail(ps,emitter,dt);
+  if(maxTrlTime==0)
+    return;
+  for(size_t i=c.begin; i<c.end; ++i) {
+    if(particles.life[i]!=0)
+      tickTrail(i,emitter);
+    }
   }
 
-void PfxBucket::tickTrail(ParState& ps, ImplEmitter& emitter, uint64_t dt) {
-  for(auto& i:ps.trail)
-    i.time+=dt;
+void PfxBucket::tickTrail(size_t i, const ImplEmitter& emitter) {
+  auto& beg = particles.trlBegin[i];
+  auto& cnt = particles.trlCount[i];
 
   Trail tx;
+  tx.time = trlClock;
   if(decl.useEmittersFOR)
-    tx.pos = ps.pos + emitter.pos; else
-    tx.pos = ps.pos;
-
-  if(ps.trail.size()==0) {
-    ps.trail.push_back(tx);
-    }
-  else if(ps.trail.back().pos!=tx.pos) {
-    bool extrude = false;
-    if(false && ps.trail.size()>1) {
-      auto u = tx.pos              - ps.trail[ps.trail.size()-2].pos;
-      auto v = ps.trail.back().pos - ps.trail[ps.trail.size()-2].pos;
-      if(std::abs(Vec3::dotProduct(u,v)-u.length()*v.length()) < 0.001f)
-        extrude = true;
+    tx.pos = particles.pos[i] + emitter.pos; else
+    tx.pos = particles.pos[i];
+
+  // last point follows particle, until it's 'trlStep' apart from previous one
+  const bool follow = cnt>1 && trlClock-particles.trailAt(i,cnt-2u).time<trlStep;
+  if(cnt>0 && (follow || particles.trailAt(i,cnt-1u).pos==tx.pos)) {
+    particles.trailAt(i,cnt-1u) = tx;
+    } else {
+    if(size_t(cnt)==particles.trlCap) {
+      // overflow: drop oldest point
+      beg = uint16_t((beg+1u)%particles.trlCap);
+      --cnt;
       }
-    if(extrude)
-      ps.trail.back() = tx; else
-      ps.trail.push_back(tx);
+    particles.trailAt(i,cnt) = tx;
+    ++cnt;
     }
-  else {
-    ps.trail.back().time = 0;
+
+  while(cnt>0 && trlClock-particles.trailAt(i,0).time>=maxTrlTime) {
+    beg = uint16_t((beg+1u)%particles.trlCap);
+    --cnt;
     }
+  }
 
-  for(size_t rm=0; rm<=ps.trail.size(); ++rm) {
-    if(rm==ps.trail.size() || ps.trail[rm].time<maxTrlTime) {
-      ps.trail.erase(ps.trail.begin(),ps.trail.begin()+int(rm));
-      break;
+void PfxBucket::tickParticles(uint64_t dt, const Frustrum* view) {
+  if(decl.isDecal())
+    return;
+  trlClock += dt;
+  frozen    = 0;
+
+  // blocks are split in chunks, for better balance of large emitters
+  const size_t chunkSz = 512;
+  simQueue.clear();
+  for(size_t i=0; i<impl.size(); ++i) {
+    auto& emitter = impl[i];
+    if(emitter.st==S_Free)
+      continue;
+    // only endless effects can be paused, one-shot effects must finish
+    emitter.frozen = (view!=nullptr && emitter.isLoop && emitter.st==S_Active && !view->testPoint(emitter.pos,visRadius));
+    if(emitter.frozen)
+      ++frozen;
+    if(emitter.block==size_t(-1))
+      continue;
+    auto& p = block[emitter.block];
+    p.ticked = (p.count>0 && !emitter.frozen);
+    if(!p.ticked)
+      continue;
+    for(size_t b=0; b<blockSize; b+=chunkSz) {
+      SimChunk c;
+      c.emitter = i;
+      c.begin   = p.offset+b;
+      c.end     = p.offset+std::min(b+chunkSz,blockSize);
+      simQueue.push_back(c);
       }
     }
+
+  if(simQueue.size()>1) {
+    Workers::parallelTasks(simQueue,[this,dt](SimChunk& c){
+      tickChunk(c,dt);
+      });
+    } else {
+    for(auto& c:simQueue)
+      tickChunk(c,dt);
+    }
+
+  for(auto& c:simQueue)
+    block[impl[c.emitter].block].count -= c.died;
   }
 
-void PfxBucket::tick(uint64_t dt, const Vec3& viewPos) {
+PfxBucket::TickStat PfxBucket::tick(uint64_t dt, const Vec3& viewPos, size_t& budget) {
+  TickStat stat;
   if(decl.isDecal()) {
     implTickDecals(dt,viewPos);
-    return;
+    return stat;
+    }
+  implTickCommon(dt,viewPos,budget,stat);
+  return stat;
+  }
+
+size_t PfxBucket::liveCount() const {
+  size_t cnt = 0;
+  for(auto& b:block)
+    if(b.allocated)
+      cnt += b.count;
+  return cnt;
+  }
+
+float PfxBucket::priority(const ImplEmitter& e, const Vec3& viewPos) const {
+  float imp = decl.m_bIsAmbientPFX ? 0.5f : 1.f;
+  if(!e.isLoop)
+    imp *= 4.f;
+  if(e.frozen)
+    imp *= 0.5f;
+  const float dist = (e.pos-viewPos).length();
+  return imp/(1.f + dist/1000.f);
+  }
+
+size_t PfxBucket::evict(size_t emitter, size_t count) {
+  auto& e = impl[emitter];
+  if(e.block==size_t(-1))
+    return 0;
+  auto&  p = block[e.block];
+  size_t n = 0;
+  for(size_t i=0; i<blockSize && n<count && p.count>0; ++i) {
+    const size_t id = p.offset+i;
+    if(particles.life[id]==0)
+      continue;
+    finalize(id);
+    p.count--;
+    ++n;
     }
-  implTickCommon(dt,viewPos);
+  if(p.count==0 && e.st==S_Fade) {
+    freeBlock(e.block);
+    e.st = S_Free;
+    }
+  return n;
+  }
+
+uint64_t PfxBucket::lodEmission(ImplEmitter& e, uint64_t emited, const Vec3& viewPos) const {
+  if(emited==0)
+    return 0;
+
+  // fewer particles far away; ambient and looped effects are reduced more
+  const float nearDist = 1000.f;
+  const float dist     = (e.pos-viewPos).length();
+  if(dist<=nearDist)
+    return emited;
+  const float minScale = (e.isLoop || decl.m_bIsAmbientPFX) ? 0.25f : 0.5f;
+  const float t        = std::min(1.f,(dist-nearDist)/(PfxObjects::viewRage-nearDist));
+  const float scale    = 1.f + (minScale-1.f)*t;
+
+  const float cnt   = float(emited)*scale + e.emitFract;
+  const float whole = std::floor(cnt);
+  e.emitFract = cnt-whole;
+  return uint64_t(whole);
   }
 
-void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
+void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos, size_t& budget, TickStat& stat) {
   bool doShrink = false;
   for(auto& emitter:impl) {
     if(emitter.st==S_Free)
@@ -439,28 +633,36 @@ void PfxBucket::implTickCommon(uint64_t dt, const Vec3& viewPos) {
       emitter.waitforNext-=dt;
 
     if(emitter.block!=size_t(-1)) {
+      // particles are already simulated by tickParticles
       auto& p = getBlock(emitter);
-      if(p.count>0) {
-        for(size_t i=0;i<blockSize;++i)
-          tick(p,emitter,i,dt);
-        if(p.count==0 && (emitter.st==S_Fade || !nearby)) {
-          // free mem
-          freeBlock(emitter.block);
-          if(emitter.st==S_Fade)
-            emitter.st = S_Free;
-          doShrink = true;
-          continue;
-          }
+      if(p.ticked && p.count==0 && (emitter.st==S_Fade || !nearby)) {
+        // free mem
+        freeBlock(emitter.block);
+        if(emitter.st==S_Fade)
+          emitter.st = S_Free;
+        doShrink = true;
+        continue;
         }
       }
 
-    if(emitter.st==S_Active && nearby) {
-      auto& p = getBlock(emitter);
-      auto dE = ppsDiff(decl,emitter.isLoop,p.timeTotal,p.timeTotal+dt);
+    if(emitter.st==S_Active && nearby && !emitter.frozen) {
+      auto& p  = getBlock(emitter);
+      auto  dE = ppsDiff(decl,emitter.isLoop,p.timeTotal,p.timeTotal+dt);
+      dE = lodEmission(emitter,dE,viewPos);
+      if(dE>budget) {
+        // one-shot effects may overshoot, PfxObjects evicts less important particles then
+        ++stat.budgetHits;
+        if(emitter.isLoop)
+          dE = budget;
+        }
+      const size_t cnt = p.count;
       tickEmit(p,emitter,dE);
+      const size_t emitted = p.count-cnt;
+      budget       -= std::min(budget,emitted);
+      stat.emitted += uint32_t(emitted);
       }
 
-    if(emitter.block!=size_t(-1)) {
+    if(emitter.block!=size_t(-1) && !emitter.frozen) {
       auto& p = getBlock(emitter);
       p.timeTotal+=dt;
       }
@@ -482,7 +684,7 @@ void PfxBucket::implTickDecals(uint64_t, const Vec3&) {
       } else
     if(emitter.st==S_Fade) {
       for(size_t i=0; i<blockSize; ++i)
-        particles[p.offset+i].life = 0;
+        particles.life[p.offset+i] = 0;
       p.count = 0;
       freeBlock(emitter.block);
       emitter.st = S_Free;
@@ -493,13 +695,13 @@ void PfxBucket::implTickDecals(uint64_t, const Vec3&) {
 void PfxBucket::tickEmit(Block& p, ImplEmitter& emitter, uint64_t emited) {
   size_t lastI = 0;
   for(size_t id=1; emited>0; ++id) {
-    const size_t i  = id%blockSize;
-    ParState&    ps = particles[i+p.offset];
-    if(ps.life==0) { // free slot
+    const size_t i    = id%blockSize;
+    auto&        life = particles.life[i+p.offset];
+    if(life==0) { // free slot
       --emited;
       lastI = i;
       init(p,emitter,i+p.offset);
-      if(ps.life==0)
+      if(life==0)
         continue;
       p.count++;
       } else {
@@ -555,15 +757,15 @@ void PfxBucket::buildSsbo() {
       continue;
 
     for(size_t pId=0; pId<blockSize; ++pId) {
-      ParState& ps = particles[pId+p.offset];
-      auto&     px = pfxCpu   [pId+p.offset];
+      const size_t i  = pId+p.offset;
+      auto&        px = pfxCpu[i];
 
-      if(ps.life==0) {
+      if(particles.life[i]==0) {
         px.size = Vec3();
         continue;
         }
 
-      const float a     = ps.lifeTime();
+      const float a     = particles.lifeTime(i);
       const Vec3  cl    = colorS*(1.f-a)        + colorE*a;
       const float clA   = visAlphaStart*(1.f-a) + visAlphaEnd*a;
 
@@ -592,7 +794,7 @@ void PfxBucket::buildSsbo() {
         }
       uint32_t colorU32;
       std::memcpy(&colorU32,&color,4);
-      buildBilboard(px,p,ps, colorU32, szX,szY,szZ);
+      buildBilboard(px,p,i, colorU32, szX,szY,szZ);
       }
     }
   }
@@ -604,26 +806,27 @@ void PfxBucket::buildSsboTrails() {
   trlCpu.reserve(trlCpu.size());
   trlCpu.clear();
 
-  for(auto& p:particles) {
-    if(p.life==0)
+  for(size_t i=0; i<particles.size(); ++i) {
+    if(particles.life[i]==0)
       continue;
-    if(p.trail.size()<2)
+    const size_t cnt = particles.trlCount[i];
+    if(cnt<2)
       continue;
 
-    float maxT = float(std::min(maxTrlTime,p.trail[0].time));
-    for(size_t r=1; r<p.trail.size(); ++r) {
+    float maxT = float(std::min(maxTrlTime,trlClock-particles.trailAt(i,0).time));
+    for(size_t r=1; r<cnt; ++r) {
       PfxState st;
-      buildTrailSegment(st,p.trail[r-1],p.trail[r],maxT);
+      buildTrailSegment(st,particles.trailAt(i,r-1),particles.trailAt(i,r),maxT);
       trlCpu.push_back(st);
       }
     }
   }
 
-void PfxBucket::buildBilboard(PfxState& v, const Block& p, const ParState& ps, const uint32_t color,
+void PfxBucket::buildBilboard(PfxState& v, const Block& p, size_t particle, const uint32_t color,
                               float szX, float szY, float szZ) {
   if(decl.useEmittersFOR)
-    v.pos = ps.pos + p.pos; else
-    v.pos = ps.pos;
+    v.pos = particles.pos[particle] + p.pos; else
+    v.pos = particles.pos[particle];
 
   v.size  = Vec3(szX,szY,szZ);
   v.color = color;
@@ -633,12 +836,12 @@ void PfxBucket::buildBilboard(PfxState& v, const Block& p, const ParState& ps, c
   v.bits0 |= uint32_t(decl.visYawAlign ? 1 : 0) << 2;
   v.bits0 |= uint32_t(0) << 3; // TODO: trails
   v.bits0 |= uint32_t(decl.visOrientation) << 4;
-  v.dir   = ps.dir;
+  v.dir   = particles.dir[particle];
   }
 
 void PfxBucket::buildTrailSegment(PfxState& v, const Trail& a, const Trail& b, float maxT) {
-  float    tA  = 1.f - float(a.time)/maxT;
-  float    tB  = 1.f - float(b.time)/maxT;
+  float    tA  = 1.f - float(trlClock-a.time)/maxT;
+  float    tB  = 1.f - float(trlClock-b.time)/maxT;
 
   uint32_t clA = mkTrailColor(tA);
   uint32_t clB = mkTrailColor(tB);
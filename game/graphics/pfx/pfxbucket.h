@@ -9,6 +9,7 @@
 
 class ParticleFx;
 class VisualObjects;
+class Frustrum;
 
 class PfxBucket {
   public:
@@ -39,6 +40,14 @@ class PfxBucket {
 
       uint64_t      waitforNext = 0;
       std::unique_ptr<PfxEmitter> next;
+
+      bool          frozen      = false; // looped emitter out of view
+      float         emitFract   = 0;     // emission remainder, after lod scale
+      };
+
+    struct TickStat {
+      uint32_t      emitted     = 0;
+      uint32_t      budgetHits  = 0;
       };
 
     struct PfxState {
@@ -60,9 +69,15 @@ class PfxBucket {
     void                        freeEmitter(size_t& id);
 
     ImplEmitter&                get(size_t id) { return impl[id]; }
-    void                        tick(uint64_t dt, const Tempest::Vec3& viewPos);
+    void                        tickParticles(uint64_t dt, const Frustrum* view);
+    TickStat                    tick(uint64_t dt, const Tempest::Vec3& viewPos, size_t& budget);
     void                        buildSsbo();
 
+    size_t                      liveCount() const;
+    size_t                      frozenCount() const { return frozen; }
+    float                       priority(const ImplEmitter& e, const Tempest::Vec3& viewPos) const;
+    size_t                      evict(size_t emitter, size_t count);
+
   private:
     struct Block final {
       bool          allocated = false;
@@ -72,20 +87,35 @@ class PfxBucket {
       size_t        count     = 0;
 
       Tempest::Vec3 pos       = {};
+      bool          ticked    = false;
       };
 
     struct Trail final {
       Tempest::Vec3 pos;
-      uint64_t      time = 0;
+      uint64_t      time = 0; // creation time, in trlClock
       };
 
-    struct ParState final {
-      uint16_t      life=0, maxLife=1;
-      Tempest::Vec3 pos, dir;
-
-      std::vector<Trail> trail;
+    // particle state as SoA; each particle owns fixed-size ring buffer of trail points
+    struct Particles final {
+      std::vector<uint16_t>      life, maxLife;
+      std::vector<Tempest::Vec3> pos, dir;
+      std::vector<uint16_t>      trlBegin, trlCount;
+      std::vector<Trail>         trail;
+      size_t                     trlCap = 0;
+
+      size_t       size() const { return life.size(); }
+      void         resize(size_t sz);
+      void         clear (size_t i);
+      float        lifeTime(size_t i) const;
+      Trail&       trailAt(size_t i, size_t k)       { return trail[i*trlCap + (trlBegin[i]+k)%trlCap]; }
+      const Trail& trailAt(size_t i, size_t k) const { return trail[i*trlCap + (trlBegin[i]+k)%trlCap]; }
+      };
 
-      float         lifeTime() const;
+    struct SimChunk final {
+      size_t        emitter = 0;
+      size_t        begin   = 0;
+      size_t        end     = 0;
+      size_t        died    = 0;
       };
 
     void                        tickEmit(Block& p, ImplEmitter& emitter, uint64_t emited);
@@ -102,14 +132,15 @@ class PfxBucket {
 
     void                        init     (Block& block, ImplEmitter& emitter, size_t particle);
     void                        finalize (size_t particle);
-    void                        tick     (Block& sys, ImplEmitter& emitter, size_t particle, uint64_t dt);
-    void                        tickTrail(ParState& ps, ImplEmitter& emitter, uint64_t dt);
+    void                        tickChunk(SimChunk& c, uint64_t dt);
+    void                        tickTrail(size_t particle, const ImplEmitter& emitter);
 
-    void                        implTickCommon(uint64_t dt, const Tempest::Vec3& viewPos);
+    void                        implTickCommon(uint64_t dt, const Tempest::Vec3& viewPos, size_t& budget, TickStat& stat);
+    uint64_t                    lodEmission(ImplEmitter& e, uint64_t emited, const Tempest::Vec3& viewPos) const;
     void                        implTickDecals(uint64_t dt, const Tempest::Vec3& viewPos);
 
     void                        buildSsboTrails();
-    void                        buildBilboard(PfxState& v, const Block& p, const ParState& ps, const uint32_t color,
+    void                        buildBilboard(PfxState& v, const Block& p, size_t particle, const uint32_t color,
                                               float szX, float szY, float szZ);
     void                        buildTrailSegment(PfxState& v, const Trail& a, const Trail& b, float maxT);
     uint32_t                    mkTrailColor(float clA) const;
@@ -125,9 +156,14 @@ class PfxBucket {
     std::vector<PfxState>       trlCpu;
 
     uint64_t                    maxTrlTime = 0;
-    size_t                      blockSize = 0;
-
-    std::vector<ParState>       particles;
+    uint64_t                    trlStep    = 0;
+    uint64_t                    trlClock   = 0;
+    size_t                      blockSize  = 0;
+    float                       visRadius  = 0;
+    size_t                      frozen     = 0;
+
+    Particles                   particles;
+    std::vector<SimChunk>       simQueue;
     std::vector<ImplEmitter>    impl;
     std::vector<Block>          block;
     bool                        forceUpdate[Resources::MaxFramesInFlight] = {};
@@ -135,5 +171,6 @@ class PfxBucket {
     static std::mt19937         rndEngine;
 
     friend class PfxEmitter;
+    friend class PfxObjects;
   };
 
@@ -3,16 +3,20 @@
 #include <Tempest/Log>
 #include <cstring>
 #include <cassert>
+#include <algorithm>
 
 #include "graphics/sceneglobals.h"
+#include "gothic.h"
 
 #include "pfxbucket.h"
 #include "particlefx.h"
+#include "utils/workers.h"
 
 using namespace Tempest;
 
 PfxObjects::PfxObjects(WorldView& world, const SceneGlobals& scene, VisualObjects& visual)
   :world(world), scene(scene), visual(visual) {
+  maxParticles = size_t(std::max(0,Gothic::settingsGetI("ENGINE","zMaxParticles")));
   }
 
 PfxObjects::~PfxObjects() {
@@ -40,15 +44,81 @@ void PfxObjects::tick(uint64_t ticks) {
   if(dt==0)
     return;
 
+  // frustum of previous frame; not available before first frame
+  auto& fr   = scene.frustrum[SceneGlobals::V_Main];
+  auto  view = (fr.width>0 ? &fr : nullptr);
+
+  // emitters may spawn new emitters and share rng: only particle simulation runs in parallel
+  std::vector<PfxBucket*> active;
+  active.reserve(bucket.size());
   for(auto& i:bucket)
-    i.tick(dt,viewerPos);
+    active.push_back(&i);
+  Workers::parallelTasks(active,[dt,view](PfxBucket* b){
+    b->tickParticles(dt,view);
+    });
+
+  frameStat = Stat();
+  size_t live = 0;
+  for(auto i:active) {
+    live += i->liveCount();
+    frameStat.culled += uint32_t(i->frozenCount());
+    }
+
+  size_t budget = size_t(-1);
+  if(maxParticles>0)
+    budget = (live<maxParticles ? maxParticles-live : 0);
+  for(auto& i:bucket) {
+    auto st = i.tick(dt,viewerPos,budget);
+    frameStat.emitted    += st.emitted;
+    frameStat.budgetHits += st.budgetHits;
+    live                 += st.emitted;
+    }
+
+  if(maxParticles>0 && live>maxParticles)
+    evictParticles(active,live-maxParticles);
+  frameStat.live = uint32_t(live-frameStat.evicted);
 
+  active.clear();
   for(auto& i:bucket)
-    i.buildSsbo();
+    active.push_back(&i);
+  Workers::parallelTasks(active,[](PfxBucket* b){
+    b->buildSsbo();
+    });
 
   lastUpdate = ticks;
   }
 
+void PfxObjects::evictParticles(std::vector<PfxBucket*>& active, size_t count) {
+  // high priority effects may overshoot the budget: take particles from least important emitters
+  struct Victim {
+    float      priority = 0;
+    PfxBucket* bucket   = nullptr;
+    size_t     emitter  = 0;
+    };
+  std::vector<Victim> victim;
+  for(auto b:active) {
+    if(b->decl.isDecal())
+      continue;
+    for(size_t i=0; i<b->impl.size(); ++i) {
+      auto& e = b->impl[i];
+      if(e.st==PfxBucket::S_Free || e.block==size_t(-1))
+        continue;
+      victim.push_back({b->priority(e,viewerPos),b,i});
+      }
+    }
+  std::sort(victim.begin(),victim.end(),[](const Victim& l, const Victim& r){
+    return l.priority<r.priority;
+    });
+
+  for(auto& v:victim) {
+    if(count==0)
+      break;
+    const size_t n = v.bucket->evict(v.emitter,count);
+    frameStat.evicted += uint32_t(n);
+    count             -= n;
+    }
+  }
+
 bool PfxObjects::isInPfxRange(const Vec3& pos) const {
   auto dp = viewerPos-pos;
   return dp.quadLength()<viewRage*viewRage;
@@ -57,6 +127,7 @@ bool PfxObjects::isInPfxRange(const Vec3& pos) const {
 void PfxObjects::preFrameUpdate(uint8_t fId) {
   for(auto i=bucket.begin(), end = bucket.end(); i!=end; ) {
     if(i->isEmpty()) {
+      bucketIndex.erase(&i->decl);
       i = bucket.erase(i);
       } else {
       ++i;
@@ -68,11 +139,12 @@ void PfxObjects::preFrameUpdate(uint8_t fId) {
   }
 
 PfxBucket& PfxObjects::getBucket(const ParticleFx &decl) {
-  for(auto& i:bucket)
-    if(&i.decl==&decl)
-      return i;
-  bucket.emplace_back(decl,*this,visual);
-  return bucket.back();
+  auto& b = bucketIndex[&decl];
+  if(b==nullptr) {
+    bucket.emplace_back(decl,*this,visual);
+    b = &bucket.back();
+    }
+  return *b;
   }
 
 PfxBucket& PfxObjects::getBucket(const Material& mat, const phoenix::vob& vob) {
@@ -6,6 +6,7 @@
 #include <memory>
 #include <list>
 #include <random>
+#include <unordered_map>
 
 #include "world/objects/pfxemitter.h"
 #include "graphics/visualobjects.h"
@@ -22,6 +23,15 @@ class PfxObjects final {
 
     static constexpr const float viewRage = 4000.f;
 
+    // per-frame counters
+    struct Stat {
+      uint32_t live       = 0;
+      uint32_t emitted    = 0;
+      uint32_t culled     = 0; // emitters, frozen out of view
+      uint32_t budgetHits = 0;
+      uint32_t evicted    = 0;
+      };
+
     void       setViewerPos(const Tempest::Vec3& pos);
 
     void       resetTicks();
@@ -29,6 +39,7 @@ class PfxObjects final {
     bool       isInPfxRange(const Tempest::Vec3& pos) const;
 
     void       preFrameUpdate(uint8_t fId);
+    Stat       stat() const { return frameStat; }
 
   private:
     struct SpriteEmitter {
@@ -40,6 +51,7 @@ class PfxObjects final {
 
     PfxBucket&                    getBucket(const ParticleFx& decl);
     PfxBucket&                    getBucket(const Material& mat, const phoenix::vob& vob);
+    void                          evictParticles(std::vector<PfxBucket*>& active, size_t count);
 
     WorldView&                    world;
     const SceneGlobals&           scene;
@@ -47,11 +59,15 @@ class PfxObjects final {
     std::recursive_mutex          sync;
 
     std::list<PfxBucket>          bucket;
+    std::unordered_map<const ParticleFx*,PfxBucket*> bucketIndex;
     std::vector<SpriteEmitter>    spriteEmit;
 
     Tempest::Vec3                 viewerPos={};
     uint64_t                      lastUpdate=0;
 
+    size_t                        maxParticles = 0; // 0 - unlimited
+    Stat                          frameStat;
+
   friend class PfxEmitter;
   friend class TrlObjects;
   };
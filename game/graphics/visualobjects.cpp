@@ -16,11 +16,17 @@ VisualObjects::~VisualObjects() {
 
 ObjectsBucket& VisualObjects::getBucket(ObjectsBucket::Type type, const Material& mat,
                                         const StaticMesh* st, const AnimMesh* anim, const StorageBuffer* desc) {
-  for(auto& i:buckets)
-    if(i->size()<ObjectsBucket::CAPACITY && i->isCompatible(type,mat,st,anim,desc))
-      return *i;
+  auto h = bucketIndex.find(ObjectsBucket::compatibilityHash(type,mat,st,anim,desc));
+  if(h!=bucketIndex.end()) {
+    for(auto i:h->second)
+      if(i->size()<ObjectsBucket::CAPACITY && i->isCompatible(type,mat,st,anim,desc))
+        return *i;
+    }
   buckets.emplace_back(ObjectsBucket::mkBucket(type,mat,*this,globals,st,anim,desc));
-  return *buckets.back();
+  // indexed by actual bucket state: mkBucket may drop 'desc'
+  auto& b = *buckets.back();
+  bucketIndex[b.compatibilityHash()].push_back(&b);
+  return b;
   }
 
 ObjectsBucket::Item VisualObjects::get(const StaticMesh& mesh, const Material& mat,
@@ -2,6 +2,8 @@
 
 #include <Tempest/Signal>
 
+#include <unordered_map>
+
 #include "objectsbucket.h"
 
 class SceneGlobals;
@@ -60,6 +62,8 @@ class VisualObjects final {
 
     std::vector<std::unique_ptr<ObjectsBucket>> buckets;
     std::vector<ObjectsBucket*>                 index;
+    // ObjectsBucket::compatibilityHash -> buckets
+    std::unordered_map<size_t,std::vector<ObjectsBucket*>> bucketIndex;
     size_t                                      lastSolidBucket = 0;
 
     std::vector<Tempest::DescriptorSet>         recycled[Resources::MaxFramesInFlight];
@@ -5,6 +5,7 @@
 #include "graphics/mesh/submesh/packedmesh.h"
 #include "world/objects/npc.h"
 #include "world/world.h"
+#include "utils/workers.h"
 #include "gothic.h"
 
 using namespace Tempest;
@@ -56,8 +57,12 @@ void WorldView::preFrameUpdate(const Matrix4x4& view, const Matrix4x4& proj,
   updateLight();
   sGlobal.setViewProject(view,proj,zNear,zFar,shadow);
 
-  pfxGroup.tick(tickCount);
-  sGlobal.lights.tick(tickCount);
+  {
+    Workers::TaskGroup upd;
+    upd.run([this,tickCount](){ pfxGroup.tick(tickCount);       });
+    upd.run([this,tickCount](){ sGlobal.lights.tick(tickCount); });
+    upd.wait();
+  }
   sGlobal.setTime(tickCount);
   sGlobal.commitUbo(fId);
 
@@ -73,6 +73,7 @@ class WorldView {
     const Tempest::AccelerationStructure& landscapeTlas();
     const SceneGlobals&  sceneGlobals() const { return sGlobal; }
     const Sky&           sky() const { return gSky; }
+    auto                 pfxStat() const -> PfxObjects::Stat { return pfxGroup.stat(); }
 
   private:
     const World&  owner;
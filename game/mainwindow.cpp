@@ -224,8 +224,14 @@ void MainWindow::paintEvent(PaintEvent& event) {
   renderer.dbgDraw(p);
 
   if(Gothic::inst().doFrate()) {
-    char fpsT[64]={};
-    std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f %.*s",fps.get(),int(info.size()),info.data());
+    char fpsT[160]={};
+    Pose::LodStat    lod;
+    PfxObjects::Stat pfx;
+    if(world!=nullptr)
+      lod = world->animLodStat();
+    if(world!=nullptr && world->view()!=nullptr)
+      pfx = world->view()->pfxStat();
+    std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f anim = %u/%u pfx = %u %.*s",fps.get(),lod.full,lod.full+lod.skipped,pfx.live,int(info.size()),info.data());
     //string_frm fpsT("fps = ", fps.get(), " ", info);
 
     auto& fnt = Resources::font();
@@ -41,11 +41,15 @@ struct CollisionWorld::Broadphase : btDbvtBroadphase {
 
   Broadphase() {
     m_deferedcollide = true;
-    rayTestStk.reserve(btDbvt::DOUBLE_STACKSIZE);
     }
 
   void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,
                const btVector3& aabbMin, const btVector3& aabbMax) {
+    // traversal stack per thread: rays can be cast concurrently, as long as world is not modified
+    static thread_local btAlignedObjectArray<const btDbvtNode*> rayTestStk;
+    if(rayTestStk.capacity()<btDbvt::DOUBLE_STACKSIZE)
+      rayTestStk.reserve(btDbvt::DOUBLE_STACKSIZE);
+
     BroadphaseRayTester callback(rayCallback);
     btAlignedObjectArray<const btDbvtNode*>* stack = &rayTestStk;
 
@@ -71,8 +75,6 @@ struct CollisionWorld::Broadphase : btDbvtBroadphase {
         *stack,
         callback);
     }
-
-  btAlignedObjectArray<const btDbvtNode*> rayTestStk;
   };
 
 struct CollisionWorld::ContructInfo {
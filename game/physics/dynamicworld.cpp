@@ -6,12 +6,14 @@
 #include "graphics/mesh/skeleton.h"
 
 #include <algorithm>
+#include <unordered_map>
 #include <cmath>
 
 #include "graphics/mesh/submesh/packedmesh.h"
 #include "world/objects/item.h"
 #include "world/bullet.h"
 #include "world/world.h"
+#include "utils/workers.h"
 
 const float DynamicWorld::ghostPadding=50-22.5f;
 const float DynamicWorld::ghostHeight =140;
@@ -41,8 +43,8 @@ struct DynamicWorld::NpcBody : btRigidBody {
   Tempest::Vec3 pos={};
   float         r=0, h=0, rX=0, rZ=0;
   bool          enable=true;
-  size_t        frozen=size_t(-1);
-  uint64_t      lastMove=0;
+  uint64_t      cell=0;
+  size_t        cellId=size_t(-1);
 
   Npc* toNpc() {
     return reinterpret_cast<Npc*>(getUserPointer());
@@ -58,15 +60,12 @@ struct DynamicWorld::NpcBody : btRigidBody {
     }
   };
 
+// Hashed uniform grid (XZ plane) of npc bodies. Body is binned by its position at last onMove;
+// queries are expanded by largest body radius, so only nearby cells are visited.
 struct DynamicWorld::NpcBodyList final {
-  struct Record final {
-    NpcBody* body = nullptr;
-    float    x    = 0.f;
-    };
+  static constexpr float cellSize = 5*100; // 5 meters
 
   NpcBodyList(DynamicWorld& wrld):wrld(wrld){
-    body  .reserve(1024);
-    frozen.reserve(1024);
     }
 
   NpcBody* create(const Tempest::Vec3 &min, const Tempest::Vec3 &max) {
@@ -94,44 +93,14 @@ struct DynamicWorld::NpcBodyList final {
     }
 
   void add(NpcBody* b){
-    Record r;
-    r.body = b;
-    r.x    = b->pos.x;
-    body.push_back(r);
-    }
-
-  bool del(void* b){
-    if(del(b,body))
-      return true;
-    if(del(b,frozen)){
-      srt=false;
-      return true;
-      }
-    return false;
+    insertCell(*b);
     }
 
-  bool del(void* b,std::vector<Record>& arr){
-    for(size_t i=0;i<arr.size();++i){
-      if(arr[i].body!=b)
-        continue;
-      arr[i]=arr.back();
-      arr.pop_back();
-      return true;
-      }
-    return false;
-    }
-
-  bool delMisordered(NpcBody* b,std::vector<Record>& arr){
-    auto&       fr = arr[b->frozen];
-    const float x  = fr.x;
-    if((b->frozen==0 || arr[b->frozen-1].x<x) &&
-       (b->frozen+1==arr.size() || x<arr[b->frozen+1].x)) {
-      fr.x = fr.body->pos.x;
+  bool del(NpcBody* b){
+    if(b->cellId==size_t(-1))
       return false;
-      } else {
-      fr.body = nullptr;
-      return true;
-      }
+    eraseCell(*b);
+    return true;
     }
 
   void resize(NpcBody& n, float h, float dx, float dz){
@@ -146,21 +115,18 @@ struct DynamicWorld::NpcBodyList final {
     }
 
   void onMove(NpcBody& n){
-    if(n.frozen!=size_t(-1)) {
-      if(delMisordered(&n,frozen)){
-        n.lastMove = tick;
-        n.frozen   = size_t(-1);
-
-        Record r;
-        r.body = &n;
-        body.push_back(r);
-        }
-      } else {
-      n.lastMove = tick;
-      }
+    if(n.cellId==size_t(-1) || n.cell==cellKey(n.pos))
+      return;
+    eraseCell(n);
+    insertCell(n);
     }
 
   bool rayTest(NpcBody& npc, const Tempest::Vec3& s, const Tempest::Vec3& e, float extR) {
+    float proj = 0;
+    return rayTest(npc,s,e,extR,proj);
+    }
+
+  bool rayTest(const NpcBody& npc, const Tempest::Vec3& s, const Tempest::Vec3& e, float extR, float& proj) const {
     if(!npc.enable)
       return false;
     auto  ln   = e       - s;
@@ -169,7 +135,7 @@ struct DynamicWorld::NpcBodyList final {
     float lenL = ln.length();
 
     float dot  = Tempest::Vec3::dotProduct(ln,at);
-    float proj = dot/(lenL<=0 ? 1.f : (lenL*lenL));
+    proj = dot/(lenL<=0 ? 1.f : (lenL*lenL));
     proj = std::max(0.f,std::min(proj,1.f));
 
     auto  nr   = ln*proj + s;
@@ -182,14 +148,19 @@ struct DynamicWorld::NpcBodyList final {
     return true;
     }
 
-  NpcBody* rayTest(const Tempest::Vec3& s, const Tempest::Vec3& e, float extR) {
-    for(auto i:body)
-      if(rayTest(*i.body, s, e, extR))
-        return i.body;
-    for(auto i:frozen)
-      if(i.body!=nullptr && rayTest(*i.body, s, e, extR))
-        return i.body;
-    return nullptr;
+  // closest to 's' body, hit by swept sphere
+  NpcBody* rayTest(const Tempest::Vec3& s, const Tempest::Vec3& e, float extR) const {
+    const float R    = 2.f*maxR + extR;
+    NpcBody*    ret  = nullptr;
+    float       best = 2.f;
+    forEach(std::min(s.x,e.x)-R, std::min(s.z,e.z)-R, std::max(s.x,e.x)+R, std::max(s.z,e.z)+R, [&](NpcBody& b) {
+      float proj = 0;
+      if(rayTest(b,s,e,extR,proj) && proj<best) {
+        best = proj;
+        ret  = &b;
+        }
+      });
+    return ret;
     }
 
   bool hasCollision(const DynamicWorld::NpcItem& obj,Tempest::Vec3& normal) {
@@ -202,38 +173,12 @@ struct DynamicWorld::NpcBodyList final {
       return false;
     const NpcBody& n = *pn;
 
-    if(srt){
-      if(hasCollision(n,frozen,normal,true))
-        return true;
-      return hasCollision(n,body,normal,false);
-      } else {
-      if(hasCollision(n,body,normal,false))
-        return true;
-      //adjustSort();
-      return hasCollision(n,frozen,normal,false);
-      }
-    }
-
-  bool hasCollision(const NpcBody& n,const std::vector<Record>& arr,Tempest::Vec3& normal, bool sorted) {
-    auto l = arr.begin();
-    auto r = arr.end();
-
-    if(sorted) {
-      const float dX = maxR+n.r;
-      l = std::lower_bound(arr.begin(),arr.end(),n.pos.x-dX,[](const Record& b,float x){ return b.x<x; });
-      r = std::upper_bound(arr.begin(),arr.end(),n.pos.x+dX,[](float x,const Record& b){ return x<b.x; });
-      }
-
-    const auto dist = std::distance(l,r);
-    if(dist<=1)
-      return false;
-
-    bool ret=false;
-    for(;l!=r;++l){
-      auto& v = (*l);
-      if(v.body!=nullptr && v.body->enable && hasCollision(n,*v.body,normal))
+    const float R   = n.r + maxR;
+    bool        ret = false;
+    forEach(n.pos.x-R, n.pos.z-R, n.pos.x+R, n.pos.z+R, [&](const NpcBody& b) {
+      if(b.enable && hasCollision(n,b,normal))
         ret = true;
-      }
+      });
     return ret;
     }
 
@@ -254,54 +199,65 @@ struct DynamicWorld::NpcBodyList final {
     return true;
     }
 
-  void adjustSort() {
-    srt=true;
-    std::sort(frozen.begin(),frozen.end(),[](Record& a,Record& b){
-      return a.x < b.x;
-      });
-    for(size_t i=0; i<frozen.size(); ++i)
-      frozen[i].body->frozen = i;
-    }
-
-  void tickAabbs() {
-    for(size_t i=0;i<body.size();) {
-      if(body[i].body->lastMove!=tick){
-        auto b = body[i];
-        body[i]=body.back();
-        body.pop_back();
+  template<class F>
+  void forEach(float x0, float z0, float x1, float z1, const F& f) const {
+    const int32_t bx = cellOf(x0), ex = cellOf(x1);
+    const int32_t bz = cellOf(z0), ez = cellOf(z1);
 
-        b.x = b.body->pos.x;
-        frozen.push_back(b);
-        } else {
-        ++i;
-        }
+    if(size_t(ex-bx+1)*size_t(ez-bz+1)>cells.size()) {
+      for(auto& c:cells)
+        for(auto b:c.second)
+          f(*b);
+      return;
       }
 
-    for(size_t i=0;i<frozen.size();) {
-      if(frozen[i].body==nullptr) {
-        frozen[i]=frozen.back();
-        frozen.pop_back();
-        }
-      else if(frozen[i].body->lastMove==tick){
-        frozen[i].body->frozen=size_t(-1);
-        body.push_back(frozen[i]);
-        frozen[i]=frozen.back();
-        frozen.pop_back();
+    for(int32_t z=bz; z<=ez; ++z)
+      for(int32_t x=bx; x<=ex; ++x) {
+        auto c = cells.find(cellKey(x,z));
+        if(c==cells.end())
+          continue;
+        for(auto b:c->second)
+          f(*b);
         }
-      else {
-        ++i;
+    }
+
+  static int32_t cellOf(float v) {
+    return int32_t(std::floor(v/cellSize));
+    }
+
+  static uint64_t cellKey(int32_t x, int32_t z) {
+    return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+    }
+
+  static uint64_t cellKey(const Tempest::Vec3& p) {
+    return cellKey(cellOf(p.x),cellOf(p.z));
+    }
+
+  void insertCell(NpcBody& b) {
+    b.cell   = cellKey(b.pos);
+    auto& c  = cells[b.cell];
+    b.cellId = c.size();
+    c.push_back(&b);
+    }
+
+  void eraseCell(NpcBody& b) {
+    auto it = cells.find(b.cell);
+    if(it!=cells.end()) {
+      auto& c = it->second;
+      if(b.cellId+1!=c.size()) {
+        c[b.cellId] = c.back();
+        c[b.cellId]->cellId = b.cellId;
         }
+      c.pop_back();
+      if(c.empty())
+        cells.erase(it);
       }
-
-    adjustSort();
-    tick++;
+    b.cellId = size_t(-1);
     }
 
-  DynamicWorld&         wrld;
-  std::vector<Record>   body, frozen;
-  bool                  srt=false;
-  uint64_t              tick=0;
-  float                 maxR=0;
+  DynamicWorld&                                      wrld;
+  std::unordered_map<uint64_t,std::vector<NpcBody*>> cells;
+  float                                              maxR=0;
   };
 
 struct DynamicWorld::BulletsList final {
@@ -631,6 +587,53 @@ float DynamicWorld::soundOclusion(const Tempest::Vec3& from, const Tempest::Vec3
   return (tlen*fr)/1.5f;
   }
 
+template<class F>
+static void rayBatch(size_t count, const F& f) {
+  static const size_t batchSize = 32;
+  if(count<=batchSize) {
+    for(size_t i=0; i<count; ++i)
+      f(i);
+    return;
+    }
+  Workers::parallelTasks((count+batchSize-1)/batchSize,[count,&f](size_t id) {
+    const size_t b = id*batchSize;
+    const size_t e = std::min(b+batchSize,count);
+    for(size_t i=b; i<e; ++i)
+      f(i);
+    });
+  }
+
+void DynamicWorld::landRay(const Tempest::Vec3* from, RayLandResult* out, size_t count, float maxDy) const {
+  world->updateAabbs();
+  if(maxDy==0)
+    maxDy = worldHeight;
+  rayBatch(count,[&](size_t i) {
+    auto& p = from[i];
+    out[i] = ray(Tempest::Vec3(p.x,p.y+ghostPadding,p.z), Tempest::Vec3(p.x,p.y-maxDy,p.z));
+    });
+  }
+
+void DynamicWorld::ray(const RaySegment* rays, RayLandResult* out, size_t count) const {
+  world->updateAabbs();
+  rayBatch(count,[&](size_t i) {
+    out[i] = ray(rays[i].from,rays[i].to);
+    });
+  }
+
+void DynamicWorld::rayNpc(const RaySegment* rays, RayQueryResult* out, size_t count) const {
+  world->updateAabbs();
+  rayBatch(count,[&](size_t i) {
+    out[i] = rayNpc(rays[i].from,rays[i].to);
+    });
+  }
+
+void DynamicWorld::soundOclusion(const RaySegment* rays, float* out, size_t count) const {
+  world->updateAabbs();
+  rayBatch(count,[&](size_t i) {
+    out[i] = soundOclusion(rays[i].from,rays[i].to);
+    });
+  }
+
 DynamicWorld::NpcItem DynamicWorld::ghostObj(std::string_view visual) {
   Tempest::Vec3 min={0,0,0}, max={0,0,0};
   if(auto sk=Resources::loadSkeleton(visual)) {
@@ -793,7 +796,6 @@ void DynamicWorld::moveBullet(BulletBody &b, const Tempest::Vec3& dir, uint64_t
   }
 
 void DynamicWorld::tick(uint64_t dt) {
-  npcList   ->tickAabbs();
   bulletList->tick(dt);
   world     ->tick(dt);
   }
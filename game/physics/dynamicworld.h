@@ -151,6 +151,11 @@ class DynamicWorld final {
       Npc* npcHit = nullptr;
       };
 
+    struct RaySegment {
+      Tempest::Vec3       from = {};
+      Tempest::Vec3       to   = {};
+      };
+
     struct BulletCallback {
       virtual ~BulletCallback()=default;
       virtual void onStop(){}
@@ -234,6 +239,12 @@ class DynamicWorld final {
     RayQueryResult rayNpc       (const Tempest::Vec3& from, const Tempest::Vec3& to) const;
     float          soundOclusion(const Tempest::Vec3& from, const Tempest::Vec3& to) const;
 
+    // batched queries: rays are cast in parallel on Workers
+    void           landRay      (const Tempest::Vec3* from, RayLandResult* out, size_t count, float maxDy=0) const;
+    void           ray          (const RaySegment* rays, RayLandResult*  out, size_t count) const;
+    void           rayNpc       (const RaySegment* rays, RayQueryResult* out, size_t count) const;
+    void           soundOclusion(const RaySegment* rays, float*          out, size_t count) const;
+
     NpcItem        ghostObj  (std::string_view visual);
     Item           staticObj (const PhysicMeshShape *src, const Tempest::Matrix4x4& m);
     Item           movableObj(const PhysicMeshShape *src, const Tempest::Matrix4x4& m);
@@ -19,6 +19,7 @@
 #include <phoenix/ext/dds_convert.hh>
 
 #include <fstream>
+#include <filesystem>
 
 #include "graphics/mesh/submesh/pfxemittermesh.h"
 #include "graphics/mesh/submesh/packedmesh.h"
@@ -34,6 +35,10 @@
 #include "gothic.h"
 #include "utils/string_frm.h"
 
+#ifdef __APPLE__
+#include "msputils.h"
+#endif
+
 using namespace Tempest;
 
 Resources* Resources::inst=nullptr;
@@ -71,9 +76,6 @@ Resources::Resources(Tempest::Device &device)
   dxMusic->addPath(Gothic::inst().nestedPath({u"_work",u"Data",u"Music",u"menu_men"}, Dir::FT_Dir));
   dxMusic->addPath(Gothic::inst().nestedPath({u"_work",u"Data",u"Music",u"orchestra"},Dir::FT_Dir));
 
-  fBuff .reserve(8*1024*1024);
-  ddsBuf.reserve(8*1024*1024);
-
   {
   Pixmap pm(1,1,Pixmap::Format::RGBA);
   uint8_t* pix = reinterpret_cast<uint8_t*>(pm.data());
@@ -117,6 +119,7 @@ void Resources::loadVdfs(const std::vector<std::u16string>& modvdfs, bool modFil
 
   for(auto& i:archives) {
     try {
+      // vdf_file::open maps the archive: entries are views into the mapping
       inst->gothicAssets.merge(phoenix::vdf_file::open(i.name), false);
       }
     catch(const phoenix::vdfs_signature_error& err) {
@@ -125,6 +128,31 @@ void Resources::loadVdfs(const std::vector<std::u16string>& modvdfs, bool modFil
     }
   inst->gothicAssets.entries.size();
 
+  // identity of loaded archive set, for on-disk caches
+  uint64_t stamp = 14695981039346656037ull;
+  auto     mix   = [&stamp](uint64_t v) {
+    stamp = (stamp ^ v) * 1099511628211ull;
+    };
+  for(auto& i:archives) {
+    for(auto c:i.name)
+      mix(uint64_t(c));
+    mix(uint64_t(i.time));
+    }
+  inst->gothicAssetsStamp = stamp;
+
+#ifdef __APPLE__
+  inst->meshCacheDir = TextCodec::toUtf16(std::string(getAppSupportDirectory("OpenGothic"))) + u"/cache/";
+#else
+  inst->meshCacheDir = u"cache/";
+#endif
+  try {
+    std::filesystem::create_directories(std::filesystem::path(inst->meshCacheDir));
+    }
+  catch(...) {
+    Log::e("unable to create mesh cache directory");
+    inst->meshCacheDir.clear();
+    }
+
   //for(auto& i:gothicAssets.getKnownFiles())
   //  Log::i(i);
 
@@ -138,30 +166,17 @@ Resources::~Resources() {
   }
 
 bool Resources::hasFile(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return static_cast<const phoenix::vdf_file&>(inst->gothicAssets).find_entry(name) != nullptr;
   }
 
-bool Resources::getFileData(std::string_view name, std::vector<uint8_t> &dat) {
-  dat.clear();
-
+bool Resources::getFileBuffer(std::string_view name, phoenix::buffer& buf) {
   const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name);
   if(entry==nullptr)
     return false;
-
-  // TODO: This should return a buffer!
-  phoenix::buffer reader = entry->open();
-  dat.assign((uint8_t*) reader.array(), (uint8_t*) reader.array() + reader.limit());
-
+  buf = entry->open();
   return true;
   }
 
-std::vector<uint8_t> Resources::getFileData(std::string_view name) {
-  std::vector<uint8_t> data;
-  getFileData(name,data);
-  return data;
-  }
-
 phoenix::buffer Resources::getFileBuffer(std::string_view name) {
   const phoenix::vdf_entry* entry = Resources::vdfsIndex().find_entry(name);
   if (entry == nullptr)
@@ -238,6 +253,24 @@ const phoenix::vdf_file& Resources::vdfsIndex() {
   return inst->gothicAssets;
   }
 
+uint64_t Resources::vdfsStamp() {
+  return inst->gothicAssetsStamp;
+  }
+
+std::u16string Resources::meshCachePath(std::string_view name, uint8_t type) {
+  if(inst->meshCacheDir.empty() || name.empty())
+    return u"";
+  std::u16string ret = inst->meshCacheDir;
+  for(auto c:name) {
+    const bool valid = ('a'<=c && c<='z') || ('A'<=c && c<='Z') || ('0'<=c && c<='9') || c=='.' || c=='_' || c=='-';
+    ret.push_back(valid ? char16_t(c) : u'_');
+    }
+  ret.push_back(u'.');
+  ret.push_back(char16_t(u'0'+type));
+  ret += u".pkm";
+  return ret;
+  }
+
 const Tempest::VertexBuffer<Resources::VertexFsq> &Resources::fsqVbo() {
   return inst->fsq;
   }
@@ -368,7 +401,7 @@ std::unique_ptr<ProtoMesh> Resources::implLoadMeshMain(std::string name) {
     if(zmsh.sub_meshes.empty())
       return nullptr;
 
-    PackedMesh packed(zmsh,PackedMesh::PK_Visual);
+    PackedMesh packed(zmsh,PackedMesh::PK_Visual,name);
     return std::unique_ptr<ProtoMesh>{new ProtoMesh(std::move(packed),name)};
     }
 
@@ -384,7 +417,7 @@ std::unique_ptr<ProtoMesh> Resources::implLoadMeshMain(std::string name) {
     if(zmm.mesh.sub_meshes.empty())
       return nullptr;
 
-    PackedMesh packed(zmm.mesh,PackedMesh::PK_VisualMorph);
+    PackedMesh packed(zmm.mesh,PackedMesh::PK_VisualMorph,name);
     return std::unique_ptr<ProtoMesh>{new ProtoMesh(std::move(packed),zmm.animations,name)};
     }
 
@@ -483,7 +516,7 @@ PfxEmitterMesh* Resources::implLoadEmiterMesh(std::string_view name) {
     if(zmsh.sub_meshes.empty())
       return nullptr;
 
-    PackedMesh packed(zmsh,PackedMesh::PK_Visual);
+    PackedMesh packed(zmsh,PackedMesh::PK_Visual,cname);
     ret = std::unique_ptr<PfxEmitterMesh>(new PfxEmitterMesh(packed));
     return ret.get();
     }
@@ -581,10 +614,11 @@ Tempest::Sound Resources::implLoadSoundBuffer(std::string_view name) {
   if(name.empty())
     return Tempest::Sound();
 
-  if(!getFileData(name,fBuff))
+  phoenix::buffer data = phoenix::buffer::empty();
+  if(!getFileBuffer(name,data))
     return Tempest::Sound();
   try {
-    Tempest::MemReader rd(fBuff.data(),fBuff.size());
+    Tempest::MemReader rd((uint8_t*)data.array(),data.limit());
     return Tempest::Sound(rd);
     }
   catch(...) {
@@ -653,7 +687,7 @@ GthFont &Resources::implLoadFont(std::string_view name, FontType type) {
   }
 
 const Texture2d *Resources::loadTexture(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::recursive_mutex> g(inst->syncTex);
   return inst->implLoadTexture(inst->texCache,name);
   }
 
@@ -728,14 +762,14 @@ Material Resources::loadMaterial(const phoenix::material& src, bool enableAlphaT
 const ProtoMesh* Resources::loadMesh(std::string_view name) {
   if(name.size()==0)
     return nullptr;
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::recursive_mutex> g(inst->syncMesh);
   return inst->implLoadMesh(name);
   }
 
 const PfxEmitterMesh* Resources::loadEmiterMesh(std::string_view name) {
   if(name.empty())
     return nullptr;
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::recursive_mutex> g(inst->syncEmi);
   return inst->implLoadEmiterMesh(name);
   }
 
@@ -749,7 +783,7 @@ const Skeleton* Resources::loadSkeleton(std::string_view name) {
 const Animation* Resources::loadAnimation(std::string_view name) {
   auto cname = std::string(name);
 
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::recursive_mutex> g(inst->syncAnim);
   auto& cache = inst->animCache;
   auto it=cache.find(cname);
   if(it!=cache.end())
@@ -757,26 +791,27 @@ const Animation* Resources::loadAnimation(std::string_view name) {
   auto t       = inst->implLoadAnimation(cname);
   auto ret     = t.get();
   cache[cname] = std::move(t);
+  if(ret!=nullptr && Gothic::settingsGetI("GAME","debugAnimMemory")!=0)
+    ret->debug();
   return ret;
   }
 
 Tempest::Sound Resources::loadSoundBuffer(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadSoundBuffer(name);
   }
 
 Dx8::PatternList Resources::loadDxMusic(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::mutex> g(inst->syncMusic);
   return inst->implLoadDxMusic(name);
   }
 
 const ProtoMesh* Resources::decalMesh(const phoenix::vob& vob) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::recursive_mutex> g(inst->syncDecal);
   return inst->implDecalMesh(vob);
   }
 
 const Resources::VobTree* Resources::loadVobBundle(std::string_view name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::mutex> g(inst->syncZen);
   return inst->implLoadVobBundle(name);
   }
 
@@ -806,7 +841,7 @@ const Resources::VobTree* Resources::implLoadVobBundle(std::string_view filename
   }
 
 const AttachBinder *Resources::bindMesh(const ProtoMesh &anim, const Skeleton &s) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  std::lock_guard<std::mutex> g(inst->syncBind);
 
   if(anim.submeshId.size()==0){
     static AttachBinder empty;
@@ -10,6 +10,7 @@
 
 #include <tuple>
 #include <string_view>
+#include <mutex>
 
 #include "graphics/material.h"
 #include "sound/soundfx.h"
@@ -97,6 +98,7 @@ class Resources final {
     static auto                      loadTextureAnim(std::string_view name) -> std::vector<const Tempest::Texture2d*>;
     static       Material            loadMaterial(const phoenix::material& src, bool enableAlphaTest);
 
+    // TODO: async loading with fallback texture, to not stall the frame on visuals spawned in view
     static const AttachBinder*       bindMesh       (const ProtoMesh& anim, const Skeleton& s);
     static const ProtoMesh*          loadMesh       (std::string_view name);
     static const PfxEmitterMesh*     loadEmiterMesh (std::string_view name);
@@ -127,12 +129,14 @@ class Resources final {
       return inst->dev.blas(b,i,offset,size);
       }
 
-    static std::vector<uint8_t>      getFileData(std::string_view name);
-    static bool                      getFileData(std::string_view name, std::vector<uint8_t>& dat);
+    // view into mapped archive, no copy
     static phoenix::buffer           getFileBuffer(std::string_view name);
+    static bool                      getFileBuffer(std::string_view name, phoenix::buffer& buf);
     static bool                      hasFile    (std::string_view fname);
 
     static const phoenix::vdf_file&  vdfsIndex();
+    static uint64_t                  vdfsStamp();
+    static std::u16string            meshCachePath(std::string_view name, uint8_t type);
 
     static const Tempest::VertexBuffer<VertexFsq>& fsqVbo();
 
@@ -199,13 +203,17 @@ class Resources final {
     Tempest::Device&                  dev;
     Tempest::SoundDevice              sound;
 
-    std::recursive_mutex              sync;
     std::unique_ptr<Dx8::DirectMusic> dxMusic;
     phoenix::vdf_file                 gothicAssets {"Root"};
+    uint64_t                          gothicAssetsStamp = 0;
+    std::u16string                    meshCacheDir;
 
-    std::vector<uint8_t>              fBuff, ddsBuf;
     Tempest::VertexBuffer<VertexFsq>  fsq;
 
+    // lock order: mesh/decal/emitter -> animation -> texture
+    std::recursive_mutex                                              syncTex, syncMesh, syncAnim, syncDecal, syncEmi;
+    std::mutex                                                        syncBind, syncZen, syncMusic;
+
     TextureCache                                                      texCache;
 
     std::unordered_map<std::string,std::unique_ptr<ProtoMesh>>        aniMeshCache;
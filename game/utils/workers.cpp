@@ -39,20 +39,28 @@ void setThreadName(const char* threadName){ (void)threadName; }
 
 using namespace Tempest;
 
+static thread_local size_t workerId = size_t(-1);
+
 Workers::Workers() {
-  size_t id=0;
-  for(auto& i:th) {
-    i = std::thread([this,id]() noexcept {
+  const size_t cnt = threadCount()-1;
+  queue.resize(cnt+1);
+  for(auto& i:queue)
+    i.reset(new Queue());
+
+  th.resize(cnt);
+  for(size_t id=0; id<cnt; ++id) {
+    th[id] = std::thread([this,id]() noexcept {
       threadFunc(id);
       });
-    ++id;
     }
   }
 
 Workers::~Workers() {
-  running   = false;
-  workTasks = MAX_THREADS;
-  execWork();
+  {
+    std::unique_lock<std::mutex> lck(sync);
+    running.store(false);
+  }
+  workWait.notify_all();
   for(auto& i:th)
     i.join();
   }
@@ -62,52 +70,196 @@ Workers &Workers::inst() {
   return w;
   }
 
-void Workers::threadFunc(size_t id) {
-  {
-  string_frm tname("Workers [",int(id),"]");
-  setThreadName(tname.c_str());
+size_t Workers::threadCount() {
+  // worker threads + caller thread, that participates in wait()
+  return std::max<size_t>(2,std::thread::hardware_concurrency());
   }
 
-  while(true) {
-    {
-    std::unique_lock<std::mutex> lck(sync);
-    while(!workInc[id])
-      workWait.wait(lck);
-    workInc[id]=false;
+void Workers::TaskGroup::wait() {
+  implWait();
+  if(err!=nullptr) {
+    auto e = std::move(err);
+    err = nullptr;
+    std::rethrow_exception(e);
     }
+  }
 
-    if(!running) {
-      workDone.fetch_add(1);
-      return;
+void Workers::TaskGroup::implWait() {
+  auto&  w    = inst();
+  size_t spin = 0;
+  while(pending.load(std::memory_order::acquire)>0) {
+    if(w.tryExec()) {
+      spin = 0;
+      continue;
       }
+    if(spin<64) {
+      ++spin;
+      std::this_thread::yield();
+      continue;
+      }
+    // nothing to run: sleep, until group is done or new job arrives
+    std::unique_lock<std::mutex> lck(w.sync);
+    while(pending.load(std::memory_order::acquire)>0 && w.queued.load()==0)
+      w.workWait.wait(lck);
+    spin = 0;
+    }
+  }
+
+void Workers::TaskGroup::setError(std::exception_ptr e) {
+  std::lock_guard<std::mutex> guard(errSync);
+  if(err==nullptr)
+    err = std::move(e);
+  }
+
+Workers::Task Workers::spawn(TaskGroup& g, std::function<void()>&& func, const Task* deps, size_t depsCnt, bool background) {
+  auto job = std::make_shared<Job>();
+  job->func       = std::move(func);
+  job->group      = &g;
+  job->background = background;
+  g.pending.fetch_add(1);
+
+  for(size_t i=0; i<depsCnt; ++i) {
+    auto& d = deps[i].job;
+    if(d==nullptr)
+      continue;
+    std::lock_guard<std::mutex> guard(d->sync);
+    if(d->done)
+      continue;
+    job->waitFor.fetch_add(1);
+    d->next.push_back(job);
+    }
+
+  if(job->waitFor.fetch_sub(1)==1)
+    push(job);
+  return Task(std::move(job));
+  }
+
+void Workers::push(std::shared_ptr<Job> job) {
+  const bool bg = job->background;
+  if(bg) {
+    bgQueued.fetch_add(1);
+    std::lock_guard<std::mutex> guard(background.sync);
+    background.jobs.push_back(std::move(job));
+    } else {
+    const size_t qId = (workerId<th.size() ? workerId : th.size());
+    queued.fetch_add(1);
+    auto& q = *queue[qId];
+    std::lock_guard<std::mutex> guard(q.sync);
+    q.jobs.push_back(std::move(job));
+    }
+  {
+    // lock-unlock to not miss the wakeup of thread, that is going to sleep
+    std::lock_guard<std::mutex> guard(sync);
+  }
+  // sleeping wait() may take notify_one, but never runs background jobs
+  if(bg)
+    workWait.notify_all();
+  else
+    workWait.notify_one();
+  }
 
-    size_t b = std::min((id  )*batchSize, workSize);
-    size_t e = std::min((id+1)*batchSize, workSize);
-    // Log::d("worker: id = ",id," [",b, ", ",e,"]");
+std::shared_ptr<Workers::Job> Workers::pop(size_t qId) {
+  if(queued.load()==0)
+    return nullptr;
 
-    if(b!=e) {
-      void* d = workSet + b*workEltSize;
-      workFunc(d,e-b);
+  if(qId<th.size()) {
+    // own queue: LIFO, to keep nested tasks hot in cache
+    auto& q = *queue[qId];
+    std::lock_guard<std::mutex> guard(q.sync);
+    if(!q.jobs.empty()) {
+      auto ret = std::move(q.jobs.back());
+      q.jobs.pop_back();
+      queued.fetch_sub(1);
+      return ret;
       }
+    }
 
-    if(size_t(workDone.fetch_add(1)+1)==workTasks)
-      std::this_thread::yield();
+  // steal: FIFO, from neighbours first
+  const size_t qCnt = queue.size();
+  for(size_t i=1; i<=qCnt; ++i) {
+    auto& q = *queue[(qId+i)%qCnt];
+    std::lock_guard<std::mutex> guard(q.sync);
+    if(!q.jobs.empty()) {
+      auto ret = std::move(q.jobs.front());
+      q.jobs.pop_front();
+      queued.fetch_sub(1);
+      return ret;
+      }
     }
+  return nullptr;
+  }
+
+bool Workers::tryExec() {
+  auto job = pop(workerId<th.size() ? workerId : th.size());
+  if(job==nullptr)
+    return false;
+  exec(std::move(job));
+  return true;
   }
 
-void Workers::execWork() {
+bool Workers::tryExecBackground() {
+  if(bgQueued.load()==0)
+    return false;
+  std::shared_ptr<Job> job;
   {
-    std::unique_lock<std::mutex> lck(sync);
-    for(size_t i=0; i<workTasks; ++i)
-      workInc[i]=true;
+    std::lock_guard<std::mutex> guard(background.sync);
+    if(background.jobs.empty())
+      return false;
+    job = std::move(background.jobs.front());
+    background.jobs.pop_front();
+    bgQueued.fetch_sub(1);
+  }
+  exec(std::move(job));
+  return true;
+  }
+
+void Workers::exec(std::shared_ptr<Job> job) {
+  auto& g = *job->group;
+  try {
+    job->func();
+    }
+  catch(...) {
+    g.setError(std::current_exception());
+    }
+  job->func = nullptr;
+
+  std::vector<std::shared_ptr<Job>> next;
+  {
+    std::lock_guard<std::mutex> guard(job->sync);
+    job->done = true;
+    next = std::move(job->next);
+  }
+  for(auto& i:next)
+    if(i->waitFor.fetch_sub(1)==1)
+      push(std::move(i));
+
+  // group can be destroyed right after this point
+  if(g.pending.fetch_sub(1,std::memory_order::acq_rel)==1) {
+    // wakeup sleeping wait(); lock-unlock to not miss it
+    {
+      std::lock_guard<std::mutex> guard(sync);
+    }
     workWait.notify_all();
+    }
   }
-  std::this_thread::yield();
+
+void Workers::threadFunc(size_t id) {
+  {
+  string_frm tname("Workers [",int(id),"]");
+  setThreadName(tname.c_str());
+  }
+  workerId = id;
 
   while(true) {
-    int expect = int(workTasks);
-    if(workDone.compare_exchange_strong(expect,0,std::memory_order::acq_rel))
-      break;
-    std::this_thread::yield();
+    if(tryExec())
+      continue;
+    if(tryExecBackground())
+      continue;
+
+    std::unique_lock<std::mutex> lck(sync);
+    while(queued.load()==0 && bgQueued.load()==0 && running.load())
+      workWait.wait(lck);
+    if(!running.load())
+      return;
     }
   }
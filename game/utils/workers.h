@@ -3,25 +3,75 @@
 #include <thread>
 #include <mutex>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <functional>
 #include <atomic>
 #include <algorithm>
 #include <condition_variable>
+#include <initializer_list>
+#include <exception>
 #include <new>
 
 class Workers final {
+  private:
+    struct Job;
+
   public:
     Workers();
     ~Workers();
 
+    class Task final {
+      public:
+        Task() = default;
+        bool isEmpty() const { return job==nullptr; }
+
+      private:
+        Task(std::shared_ptr<Job> j):job(std::move(j)) {}
+        std::shared_ptr<Job> job;
+      friend class Workers;
+      };
+
+    // Set of tasks, that can be awaited together. Tasks may spawn nested groups;
+    // waiting thread executes pending jobs, and sleeps only when there is nothing to run.
+    // Note: wait() helps with any regular job, not only with jobs of own group - long jobs
+    // must go to runBackground, so a frame wait can't pick them up.
+    // First exception, thrown by a task, is rethrown from wait().
+    class TaskGroup final {
+      public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup&) = delete;
+        ~TaskGroup() { implWait(); }
+
+        template<class F>
+        Task run(F&& func, std::initializer_list<Task> deps = {}) {
+          return inst().spawn(*this,std::function<void()>(std::forward<F>(func)),deps.begin(),deps.size(),false);
+          }
+        // long-running job: executed only by idle worker threads, never from wait()
+        template<class F>
+        Task runBackground(F&& func) {
+          return inst().spawn(*this,std::function<void()>(std::forward<F>(func)),nullptr,0,true);
+          }
+        void wait();
+
+      private:
+        void implWait();
+        void setError(std::exception_ptr e);
+
+        std::atomic_size_t pending{0};
+        std::mutex         errSync;
+        std::exception_ptr err;
+      friend class Workers;
+      };
+
     template<class T,class F>
     static void parallelFor(T* b, T* e, const F& func) {
-      inst().runParallelFor(b,std::distance(b,e),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(b,size_t(std::distance(b,e)),threadCount(),func);
       }
 
     template<class T,class F>
     static void parallelFor(std::vector<T>& data, const F& func) {
-      inst().runParallelFor(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(data.data(),data.size(),threadCount(),func);
       }
 
     template<class T,class F>
@@ -31,7 +81,7 @@ class Workers final {
 
     template<class T,class F>
     static void parallelTasks(std::vector<T>& data, const F& func) {
-      inst().runParallelFor2(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor2(data.data(),data.size(),func);
       }
 
     template<class F>
@@ -40,91 +90,101 @@ class Workers final {
       }
 
     static uint8_t maxThreads() {
-      uint32_t th = std::thread::hardware_concurrency();
-      if(th>MAX_THREADS)
-        return MAX_THREADS;
+      size_t th = threadCount();
+      if(th>255)
+        return 255;
       return uint8_t(th);
       }
 
   private:
-    enum { MAX_THREADS=16 };
+    struct Job {
+      std::function<void()>             func;
+      TaskGroup*                        group = nullptr;
+      std::atomic_int                   waitFor{1};
+      std::mutex                        sync;
+      bool                              done       = false;
+      bool                              background = false;
+      std::vector<std::shared_ptr<Job>> next;
+      };
+
+    struct alignas(64) Queue {
+      std::mutex                        sync;
+      std::deque<std::shared_ptr<Job>>  jobs;
+      };
 
-    void threadFunc(size_t id);
-    void execWork();
     static Workers& inst();
+    static size_t   threadCount();
+
+    void threadFunc(size_t id);
+    Task spawn(TaskGroup& g, std::function<void()>&& func, const Task* deps, size_t depsCnt, bool background);
+    void push(std::shared_ptr<Job> job);
+    bool tryExec();
+    bool tryExecBackground();
+    std::shared_ptr<Job> pop(size_t qId);
+    void exec(std::shared_ptr<Job> job);
 
     template<class T,class F>
     void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      workSize    = sz;
-      workEltSize = sizeof(T);
-
-      workFunc = [&func](void* data,size_t sz) {
-        T* tdata = reinterpret_cast<T*>(data);
-        for(size_t i=0;i<sz;++i)
-          func(tdata[i]);
-        };
-
-      if(maxTh>MAX_THREADS)
-        workTasks = MAX_THREADS; else
-        workTasks = maxTh;
-
-      batchSize = std::max<size_t>(16,(sz+workTasks-1)/workTasks);
-      execWork();
+      if(sz==0)
+        return;
+      const size_t tasks     = std::max<size_t>(1,std::min(maxTh,threadCount()));
+      const size_t batchSize = std::max<size_t>(16,(sz+tasks-1)/tasks);
+
+      TaskGroup g;
+      for(size_t b=0; b<sz; b+=batchSize) {
+        const size_t e = std::min(b+batchSize,sz);
+        g.run([data,b,e,&func]() {
+          for(size_t i=b; i<e; ++i)
+            func(data[i]);
+          });
+        }
+      g.wait();
       }
 
-    template<class T,class F>
-    void runParallelFor2(T* data, size_t sz, size_t maxTh, const F& func) {
-      workTasks   = std::min<size_t>(MAX_THREADS, sz);
-      workTasks   = std::min<size_t>(workTasks,  maxTh);
-      workSize    = workTasks;
-      batchSize   = 1;
-      workEltSize = 0;
-
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      taskDone.store(0);
-      workFunc = [this, &func, sz](void* data, size_t /*sz*/) {
-        T* tdata = reinterpret_cast<T*>(data);
-        const size_t increment = (64+sizeof(T)-1)/sizeof(T);
-        while(true) {
-          size_t id = size_t(taskDone.fetch_add(increment));
-          for(size_t i=0;i<increment;++i) {
-            if(id+i<sz)
-              func(tdata[id+i]);
+    template<class F>
+    void runChunked(size_t sz, size_t increment, const F& func) {
+      // one job per thread; jobs pull small chunks from shared cursor, for balance
+      const size_t chunks = (sz+increment-1)/increment;
+      const size_t tasks  = std::min(threadCount(),chunks);
+
+      std::atomic_size_t cursor{0};
+      TaskGroup g;
+      for(size_t t=0; t<tasks; ++t) {
+        g.run([sz,increment,&cursor,&func]() {
+          while(true) {
+            const size_t b = cursor.fetch_add(increment);
+            if(b>=sz)
+              return;
+            const size_t e = std::min(b+increment,sz);
+            for(size_t i=b; i<e; ++i)
+              func(i);
             }
+          });
+        }
+      g.wait();
+      }
 
-          if(id+increment>=sz)
-            break;
-          }
-        };
-      execWork();
+    template<class T,class F>
+    void runParallelFor2(T* data, size_t sz, const F& func) {
+      const size_t increment = (64+sizeof(T)-1)/sizeof(T);
+      runChunked(sz,increment,[data,&func](size_t i) { func(data[i]); });
       }
 
     template<class F>
     void runParallelTasks(size_t taskCount, const F& func) {
-      workTasks   = taskCount;
-      workSize    = taskCount;
-      batchSize   = 1;
-      workSet     = nullptr;
-      workEltSize = 1;
-      workFunc = [&func](void* data, size_t sz) {
-        func(reinterpret_cast<uintptr_t>(data));
-        };
-      execWork();
+      runChunked(taskCount,1,[&func](size_t i) { func(uintptr_t(i)); });
       }
 
-    std::thread                       th     [MAX_THREADS];
-    bool                              workInc[MAX_THREADS] = {};
-
-    bool                              running=true;
+    std::vector<std::thread>            th;
+    // one queue per worker thread, plus shared queue for external threads
+    std::vector<std::unique_ptr<Queue>> queue;
+    // long jobs: polled by worker threads only
+    Queue                               background;
 
-    uint8_t*                          workSet=nullptr;
-    size_t                            workSize=0, batchSize=0, workEltSize=0;
-    size_t                            workTasks=0;
-    std::function<void(void*,size_t)> workFunc;
+    std::atomic_bool                    running{true};
+    std::atomic_size_t                  queued{0};
+    std::atomic_size_t                  bgQueued{0};
 
-    std::mutex                        sync;
-    std::condition_variable           workWait;
-    std::atomic_int                   workDone{0};
-    std::atomic_int                   taskDone{0};
+    std::mutex                          sync;
+    std::condition_variable             workWait;
   };
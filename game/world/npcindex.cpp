@@ -0,0 +1,114 @@
+#include "npcindex.h"
+
+#include "world/objects/npc.h"
+
+#include <cmath>
+
+static const float cellSize = 10*100; // 10 meters
+
+void NpcIndex::clear() {
+  slot.clear();
+  cells.clear();
+  }
+
+void NpcIndex::add(Npc* npc, size_t order) {
+  if(slot.find(npc)!=slot.end())
+    return;
+  Slot s;
+  s.order = order;
+  insertCell(npc,s);
+  slot[npc] = s;
+  }
+
+void NpcIndex::del(Npc* npc) {
+  auto it = slot.find(npc);
+  if(it==slot.end())
+    return;
+  const Slot s = it->second;
+  slot.erase(it);
+  eraseCell(s);
+  }
+
+void NpcIndex::move(Npc* npc) {
+  auto it = slot.find(npc);
+  if(it==slot.end())
+    return;
+  auto& s = it->second;
+  if(s.cell==cellKey(npc->position()))
+    return;
+  eraseCell(s);
+  insertCell(npc,s);
+  }
+
+void NpcIndex::move(Npc* npc, size_t order) {
+  auto it = slot.find(npc);
+  if(it==slot.end())
+    return;
+  auto& s = it->second;
+  s.order = order;
+  if(s.cell==cellKey(npc->position()))
+    return;
+  eraseCell(s);
+  insertCell(npc,s);
+  }
+
+size_t NpcIndex::order(const Npc* npc) const {
+  auto it = slot.find(npc);
+  if(it==slot.end())
+    return size_t(-1);
+  return it->second.order;
+  }
+
+void NpcIndex::implFind(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Npc&)) const {
+  const int32_t bx = cellOf(p.x-R), ex = cellOf(p.x+R);
+  const int32_t bz = cellOf(p.z-R), ez = cellOf(p.z+R);
+
+  if(size_t(ex-bx+1)*size_t(ez-bz+1)>cells.size()) {
+    for(auto& c:cells)
+      for(auto npc:c.second)
+        func(ctx,*npc);
+    return;
+    }
+
+  for(int32_t z=bz; z<=ez; ++z)
+    for(int32_t x=bx; x<=ex; ++x) {
+      auto c = cells.find(cellKey(x,z));
+      if(c==cells.end())
+        continue;
+      for(auto npc:c->second)
+        func(ctx,*npc);
+      }
+  }
+
+int32_t NpcIndex::cellOf(float v) {
+  return int32_t(std::floor(v/cellSize));
+  }
+
+uint64_t NpcIndex::cellKey(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+  }
+
+uint64_t NpcIndex::cellKey(const Tempest::Vec3& p) {
+  return cellKey(cellOf(p.x),cellOf(p.z));
+  }
+
+void NpcIndex::insertCell(Npc* npc, Slot& s) {
+  s.cell   = cellKey(npc->position());
+  auto& c  = cells[s.cell];
+  s.cellId = c.size();
+  c.push_back(npc);
+  }
+
+void NpcIndex::eraseCell(const Slot& s) {
+  auto it = cells.find(s.cell);
+  if(it==cells.end())
+    return;
+  auto& c = it->second;
+  if(s.cellId+1!=c.size()) {
+    c[s.cellId] = c.back();
+    slot.find(c[s.cellId])->second.cellId = s.cellId;
+    }
+  c.pop_back();
+  if(c.empty())
+    cells.erase(it);
+  }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Tempest/Point>
+
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+class Npc;
+
+// Hashed uniform grid of npc positions (XZ plane).
+// Npc reports every position change via move(), so cells are always up to date.
+class NpcIndex final {
+  public:
+    NpcIndex() = default;
+
+    void   clear();
+    void   add  (Npc* npc, size_t order);
+    void   del  (Npc* npc);
+    void   move (Npc* npc);
+    void   move (Npc* npc, size_t order);
+    size_t order(const Npc* npc) const;
+    size_t size() const { return slot.size(); }
+
+    // note: callback must not move npc's, since cells are iterated in place
+    template<class Func>
+    void find(const Tempest::Vec3& p, float R, const Func& f) const {
+      implFind(p,R,&f,[](const void* ctx, Npc& npc){
+        auto& f = *reinterpret_cast<const Func*>(ctx);
+        f(npc);
+        });
+      }
+
+  private:
+    struct Slot {
+      uint64_t cell   = 0;
+      size_t   cellId = 0;
+      size_t   order  = 0; // index in owner's npc list
+      };
+
+    std::unordered_map<const Npc*,Slot>            slot;
+    std::unordered_map<uint64_t,std::vector<Npc*>> cells;
+
+    void            implFind(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Npc&)) const;
+    static int32_t  cellOf(float v);
+    static uint64_t cellKey(int32_t x, int32_t z);
+    static uint64_t cellKey(const Tempest::Vec3& p);
+    void            insertCell(Npc* npc, Slot& s);
+    void            eraseCell (const Slot& s);
+  };
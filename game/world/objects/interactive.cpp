@@ -1005,6 +1005,7 @@ void Interactive::marchInteractives(DbgPainter &p) const {
 void Interactive::moveEvent() {
   Vob::moveEvent();
   visual.setObjMatrix(transform());
+  world.updateVobIndex(*this);
   }
 
 float Interactive::extendedSearchRadius() const {
@@ -314,6 +314,5 @@ void Item::updateMatrix() {
 void Item::moveEvent() {
   view  .setObjMatrix(transform());
   physic.setObjMatrix(transform());
-  if(!isDynamic())
-    world.invalidateVobIndex();
+  world.updateVobIndex(*this);
   }
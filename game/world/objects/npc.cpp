@@ -357,6 +357,7 @@ bool Npc::setPosition(float ix, float iy, float iz) {
   z = iz;
   durtyTranform |= TR_Pos;
   physic.setPosition(Vec3{x,y,z});
+  owner.updateNpcIndex(*this);
   return true;
   }
 
@@ -369,6 +370,7 @@ void Npc::setViewPosition(const Tempest::Vec3& pos) {
   y = pos.y;
   z = pos.z;
   durtyTranform |= TR_Pos;
+  owner.updateNpcIndex(*this);
   }
 
 int Npc::aiOutputOrderId() const {
@@ -1637,14 +1639,14 @@ bool Npc::implAiFlee(uint64_t dt) {
   const WayPoint* wp      = nullptr;
   const float     maxDist = 5*100; // 5 meters
 
-  owner.findWayPoint(position(),[&](const WayPoint& p) {
+  owner.detectWayPoint(position(),maxDist,[&](const WayPoint& p) {
     if(p.useCounter()>0 || qDistTo(&p)>maxDist*maxDist)
-      return false;
+      return;
+    if(wp!=nullptr && oth.qDistTo(&p)<=oth.qDistTo(wp))
+      return;
     if(!canSeeNpc(p.x,p.y+10,p.z,true))
-      return false;
-    if(wp==nullptr || oth.qDistTo(&p)>oth.qDistTo(wp))
-      wp = &p;
-    return false;
+      return;
+    wp = &p;
     });
 
   if(go2.flag!=GT_Flee && go2.flag!=GT_No) {
@@ -3938,6 +3940,14 @@ bool Npc::canSeeNpc(float tx, float ty, float tz, bool freeLos) const {
   return int32_t(s&SensesBit::SENSE_SEE)!=0;
   }
 
+uint32_t Npc::currentRoom() const {
+  if(roomPos.x!=x || roomPos.y!=y || roomPos.z!=z) {
+    roomPos = Tempest::Vec3(x,y,z);
+    roomId  = owner.roomIdAt(roomPos);
+    }
+  return roomId;
+  }
+
 SensesBit Npc::canSenseNpc(const Npc &oth, bool freeLos, float extRange) const {
   const auto mid     = oth.bounds().midTr;
   const bool isNoisy = (oth.bodyStateMasked()!=BodyState::BS_SNEAK);
@@ -3953,7 +3963,7 @@ SensesBit Npc::canSenseNpc(float tx, float ty, float tz, bool freeLos, bool isNo
     return SensesBit::SENSE_NONE;
 
   SensesBit ret=SensesBit::SENSE_NONE;
-  if(owner.roomAt({tx,ty,tz})==owner.roomAt({x,y,z})) {
+  if(owner.roomIdAt({tx,ty,tz})==currentRoom()) {
     ret = ret | SensesBit::SENSE_SMELL;
     if(isNoisy)
       ret = ret | SensesBit::SENSE_HEAR;
@@ -4086,7 +4096,19 @@ void Npc::updateAnimation(uint64_t dt) {
     durtyTranform = 0;
     }
 
-  bool syncAtt = visual.updateAnimation(this,owner,dt);
+  // animation LOD: skeletons of far npc's are sampled at reduced rate, and not at all, if out of view
+  Pose::Lod lod;
+  if(aiPolicy==ProcessPolicy::AiFar) {
+    lod.sampleInterval = 100;
+    lod.interpolate    = true;
+    }
+  else if(aiPolicy==ProcessPolicy::AiFar2) {
+    lod.sampleInterval = 250;
+    }
+  if(lod.sampleInterval>0)
+    lod.hidden = !visual.isVisible();
+
+  bool syncAtt = visual.updateAnimation(this,owner,dt,lod);
   if(syncAtt)
     visual.syncAttaches();
   }
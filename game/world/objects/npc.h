@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <string>
 #include <deque>
+#include <limits>
 
 #include <phoenix/ext/daedalus_classes.hh>
 
@@ -495,6 +496,8 @@ class Npc final {
 
     uint8_t   calcAniComb() const;
 
+    uint32_t           currentRoom() const;
+
     bool               isAlignedToGround() const;
     Tempest::Vec3      groundNormal() const;
     Tempest::Matrix4x4 mkPositionMatrix() const;
@@ -519,6 +522,10 @@ class Npc final {
     uint8_t                        durtyTranform=0;
     Tempest::Vec3                  lastGroundNormal;
 
+    // bsp room (cache), resolved again only after npc moved
+    mutable Tempest::Vec3          roomPos = Tempest::Vec3(std::numeric_limits<float>::quiet_NaN(),0,0);
+    mutable uint32_t               roomId  = uint32_t(-1);
+
     DynamicWorld::NpcItem          physic;
 
     WalkBit                        wlkMode                 =WalkBit::WM_Run;
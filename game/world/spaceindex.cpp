@@ -2,25 +2,27 @@
 
 #include "world/objects/vob.h"
 
-void BaseSpaceIndex::clear() {
+#include <cmath>
+
+void KdSpaceIndex::clear() {
   arr.clear();
   index.clear();
   dynamic.clear();
   }
 
-void BaseSpaceIndex::invalidate() {
+void KdSpaceIndex::invalidate() {
   index.clear();
   dynamic.clear();
   }
 
-void BaseSpaceIndex::add(Vob* v) {
+void KdSpaceIndex::add(Vob* v) {
   arr.push_back(v);
   index.reserve(arr.size());
   index.clear();
   dynamic.clear();
   }
 
-void BaseSpaceIndex::del(Vob* v) {
+void KdSpaceIndex::del(Vob* v) {
   for(size_t i=0;i<arr.size();++i) {
     if(arr[i]==v) {
       arr[i] = arr.back();
@@ -32,7 +34,12 @@ void BaseSpaceIndex::del(Vob* v) {
     }
   }
 
-bool BaseSpaceIndex::hasObject(const Vob* v) const {
+void KdSpaceIndex::move(Vob* v) {
+  if(!v->isDynamic())
+    invalidate();
+  }
+
+bool KdSpaceIndex::hasObject(const Vob* v) const {
   if(v==nullptr)
     return false;
   for(size_t i=0;i<arr.size();++i)
@@ -41,7 +48,7 @@ bool BaseSpaceIndex::hasObject(const Vob* v) const {
   return false;
   }
 
-void BaseSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
+void KdSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
   if(index.size()==0)
     buildIndex();
   for(auto& i:dynamic)
@@ -49,7 +56,7 @@ void BaseSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void
   implFind(index.data(),index.size(),0,p,R,ctx,func);
   }
 
-void BaseSpaceIndex::buildIndex() {
+void KdSpaceIndex::buildIndex() {
   size_t cnt = 0;
   index.resize(arr.size());
   dynamic.clear();
@@ -65,7 +72,7 @@ void BaseSpaceIndex::buildIndex() {
   buildIndex(index.data(),index.size(),0);
   }
 
-void BaseSpaceIndex::buildIndex(Vob** v, size_t cnt, uint8_t depth) {
+void KdSpaceIndex::buildIndex(Vob** v, size_t cnt, uint8_t depth) {
   depth%=3;
   sort(v,cnt,depth);
   size_t mid = cnt/2;
@@ -79,7 +86,7 @@ void BaseSpaceIndex::buildIndex(Vob** v, size_t cnt, uint8_t depth) {
     }
   }
 
-void BaseSpaceIndex::sort(Vob** v, size_t cnt, uint8_t component) {
+void KdSpaceIndex::sort(Vob** v, size_t cnt, uint8_t component) {
   bool (*predicate)(const Vob* a, const Vob* b) = nullptr;
   switch(component) {
     case 0:
@@ -95,7 +102,7 @@ void BaseSpaceIndex::sort(Vob** v, size_t cnt, uint8_t component) {
   std::sort(v,v+cnt,predicate);
   }
 
-void BaseSpaceIndex::implFind(Vob** v, size_t cnt, uint8_t depth,
+void KdSpaceIndex::implFind(Vob** v, size_t cnt, uint8_t depth,
                               const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
   if(cnt==0)
     return;
@@ -130,3 +137,114 @@ void BaseSpaceIndex::implFind(Vob** v, size_t cnt, uint8_t depth,
       break;
     }
   }
+
+
+void GridSpaceIndex::clear() {
+  arr.clear();
+  slot.clear();
+  cells.clear();
+  }
+
+void GridSpaceIndex::invalidate() {
+  // objects are re-binned on move; static/dynamic state is irrelevant to the grid
+  }
+
+void GridSpaceIndex::add(Vob* v) {
+  Slot s;
+  s.arrId = arr.size();
+  arr.push_back(v);
+  insertCell(v,s);
+  slot[v] = s;
+  }
+
+void GridSpaceIndex::del(Vob* v) {
+  auto it = slot.find(v);
+  if(it==slot.end())
+    return;
+  const Slot s = it->second;
+  slot.erase(it);
+  eraseCell(s);
+
+  if(s.arrId+1!=arr.size()) {
+    arr[s.arrId] = arr.back();
+    slot[arr[s.arrId]].arrId = s.arrId;
+    }
+  arr.pop_back();
+  }
+
+void GridSpaceIndex::move(Vob* v) {
+  auto it = slot.find(v);
+  if(it==slot.end())
+    return;
+  auto& s = it->second;
+  if(s.cell==cellKey(v->position()))
+    return;
+  eraseCell(s);
+  insertCell(v,s);
+  }
+
+bool GridSpaceIndex::hasObject(const Vob* v) const {
+  if(v==nullptr)
+    return false;
+  return slot.find(v)!=slot.end();
+  }
+
+void GridSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
+  const float qR = (R+675.f);
+
+  const int32_t bx = cellOf(p.x-qR), ex = cellOf(p.x+qR);
+  const int32_t bz = cellOf(p.z-qR), ez = cellOf(p.z+qR);
+  if(size_t(ex-bx+1)*size_t(ez-bz+1)>cells.size()) {
+    // query is larger than populated area
+    for(auto& c:cells) {
+      for(auto v:c.second)
+        if((v->position()-p).quadLength()<=qR*qR)
+          func(ctx,v);
+      }
+    return;
+    }
+
+  for(int32_t z=bz; z<=ez; ++z)
+    for(int32_t x=bx; x<=ex; ++x) {
+      auto c = cells.find(cellKey(x,z));
+      if(c==cells.end())
+        continue;
+      for(auto v:c->second)
+        if((v->position()-p).quadLength()<=qR*qR)
+          func(ctx,v);
+      }
+  }
+
+int32_t GridSpaceIndex::cellOf(float v) {
+  static const float cellSize = 10*100; // 10 meters
+  return int32_t(std::floor(v/cellSize));
+  }
+
+uint64_t GridSpaceIndex::cellKey(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(z));
+  }
+
+uint64_t GridSpaceIndex::cellKey(const Tempest::Vec3& p) {
+  return cellKey(cellOf(p.x),cellOf(p.z));
+  }
+
+void GridSpaceIndex::insertCell(Vob* v, Slot& s) {
+  auto& c = cells[cellKey(v->position())];
+  s.cell   = cellKey(v->position());
+  s.cellId = c.size();
+  c.push_back(v);
+  }
+
+void GridSpaceIndex::eraseCell(const Slot& s) {
+  auto it = cells.find(s.cell);
+  if(it==cells.end())
+    return;
+  auto& c = it->second;
+  if(s.cellId+1!=c.size()) {
+    c[s.cellId] = c.back();
+    slot[c[s.cellId]].cellId = s.cellId;
+    }
+  c.pop_back();
+  if(c.empty())
+    cells.erase(it);
+  }
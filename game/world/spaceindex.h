@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <array>
 #include <memory>
+#include <unordered_map>
 #include <Tempest/Point>
 
 #include "utils/workers.h"
@@ -13,24 +14,40 @@ class Vob;
 
 class BaseSpaceIndex {
   public:
-    void   clear();
     size_t size() const { return arr.size(); }
-    void   invalidate();
 
   protected:
     BaseSpaceIndex() = default;
-    void               add(Vob* v);
-    void               del(Vob* v);
-    bool               hasObject(const Vob* v) const;
 
-    void               find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*));
     template<class Func>
     void               parallelFor(Func f);
     Vob**              data() { return arr.data(); }
     Vob*const*         data() const { return arr.data(); }
 
-  private:
     std::vector<Vob*>  arr;
+  };
+
+template<class Func>
+void BaseSpaceIndex::parallelFor(Func func) {
+  Workers::parallelTasks(arr,func);
+  }
+
+// sorted k-d index: rebuilt after any change, dynamic objects are scanned linearly
+class KdSpaceIndex : public BaseSpaceIndex {
+  public:
+    void   clear();
+    void   invalidate();
+
+  protected:
+    KdSpaceIndex() = default;
+    void               add (Vob* v);
+    void               del (Vob* v);
+    void               move(Vob* v);
+    bool               hasObject(const Vob* v) const;
+
+    void               find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*));
+
+  private:
     std::vector<Vob*>  index;
     std::vector<Vob*>  dynamic;
 
@@ -40,38 +57,70 @@ class BaseSpaceIndex {
     void               implFind(Vob** v, size_t cnt, uint8_t depth, const Tempest::Vec3& p, float R, const void* ctx, void(*func)(const void*, Vob*));
   };
 
-template<class Func>
-void BaseSpaceIndex::parallelFor(Func func) {
-  Workers::parallelTasks(arr,func);
-  }
+// hashed uniform grid in XZ plane: O(1) insert, move and remove
+class GridSpaceIndex : public BaseSpaceIndex {
+  public:
+    void   clear();
+    void   invalidate();
+
+  protected:
+    GridSpaceIndex() = default;
+    void               add (Vob* v);
+    void               del (Vob* v);
+    void               move(Vob* v);
+    bool               hasObject(const Vob* v) const;
+
+    void               find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*));
+
+  private:
+    struct Slot {
+      uint64_t cell   = 0;
+      size_t   arrId  = 0;
+      size_t   cellId = 0;
+      };
+
+    std::unordered_map<const Vob*,Slot>             slot;
+    std::unordered_map<uint64_t,std::vector<Vob*>> cells;
+
+    static int32_t     cellOf(float v);
+    static uint64_t    cellKey(int32_t x, int32_t z);
+    static uint64_t    cellKey(const Tempest::Vec3& p);
+    void               insertCell(Vob* v, Slot& s);
+    void               eraseCell (const Slot& s);
+  };
 
 
-template<class T>
-class SpaceIndex final : public BaseSpaceIndex {
+template<class T, class Index = GridSpaceIndex>
+class SpaceIndex final : public Index {
   public:
     SpaceIndex()=default;
 
     void add(T* v) {
-      BaseSpaceIndex::add(v);
+      Index::add(v);
       }
 
     void del(T* v) {
-      BaseSpaceIndex::del(v);
+      Index::del(v);
+      }
+
+    // notify index, that object has moved
+    void move(T* v) {
+      Index::move(v);
       }
 
     bool hasObject(const T* v) const {
-      return BaseSpaceIndex::hasObject(v);
+      return Index::hasObject(v);
       }
 
-    T**       begin()        { return reinterpret_cast<T**>(data()); }
-    T**       end()          { return begin()+size();                }
+    T**       begin()        { return reinterpret_cast<T**>(this->data()); }
+    T**       end()          { return begin()+this->size();                }
 
-    T*const*  begin() const  { return reinterpret_cast<T*const*>(data()); }
-    T*const*  end()   const  { return begin()+size();                     }
+    T*const*  begin() const  { return reinterpret_cast<T*const*>(this->data()); }
+    T*const*  end()   const  { return begin()+this->size();                     }
 
     template<class Func>
     void find(const Tempest::Vec3& p, float R, const Func& f) {
-      return BaseSpaceIndex::find(p,R,&f,[](const void* ctx, Vob* v){
+      return Index::find(p,R,&f,[](const void* ctx, Vob* v){
         auto& f = *reinterpret_cast<const Func*>(ctx);
         f(*reinterpret_cast<T*>(v));
         });
@@ -79,7 +128,6 @@ class SpaceIndex final : public BaseSpaceIndex {
 
     template<class F>
     void parallelFor(F func) {
-      BaseSpaceIndex::parallelFor([&func](Vob* v){ func(*reinterpret_cast<T*>(v)); });
+      Index::parallelFor([&func](Vob* v){ func(*reinterpret_cast<T*>(v)); });
       }
   };
-
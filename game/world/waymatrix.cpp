@@ -3,6 +3,7 @@
 #include <Tempest/Log>
 #include <algorithm>
 #include <limits>
+#include <cmath>
 
 #include "utils/dbgpainter.h"
 #include "utils/versioninfo.h"
@@ -33,9 +34,132 @@ WayMatrix::WayMatrix(World &world, const phoenix::way_net &dat)
   for(auto& i:wayPoints)
     if(i.name.find("START")!=std::string::npos)
       startPoints.push_back(i);
+  }
+
+void WayMatrix::PointGrid::build(std::vector<const WayPoint*> pt) {
+  points = std::move(pt);
+  cell.clear();
+  w = 0;
+  h = 0;
+  if(points.empty())
+    return;
+
+  float x1 = points[0]->x, z1 = points[0]->z;
+  x0 = x1;
+  z0 = z1;
+  for(auto i:points) {
+    x0 = std::min(x0,i->x);
+    z0 = std::min(z0,i->z);
+    x1 = std::max(x1,i->x);
+    z1 = std::max(z1,i->z);
+    }
+
+  // ~4 points per cell, but not smaller than 5 meters
+  const float area = std::max(1.f,(x1-x0)*(z1-z0));
+  cellSz = std::max(5.f*100.f, std::sqrt(area*4.f/float(points.size())));
+  w      = std::min<int32_t>(1024,int32_t((x1-x0)/cellSz)+1);
+  h      = std::min<int32_t>(1024,int32_t((z1-z0)/cellSz)+1);
+  cellSz = std::max(cellSz,std::max((x1-x0)/float(w),(z1-z0)/float(h)));
+
+  // counting sort by cell
+  std::vector<uint32_t> cellOf(points.size());
+  cell.assign(size_t(w*h)+1,0);
+  for(size_t i=0; i<points.size(); ++i) {
+    cellOf[i] = uint32_t(cellZ(points[i]->z)*w + cellX(points[i]->x));
+    cell[cellOf[i]+1]++;
+    }
+  for(size_t i=1; i<cell.size(); ++i)
+    cell[i] += cell[i-1];
+
+  std::vector<const WayPoint*> sorted(points.size());
+  std::vector<uint32_t>        at(cell.begin(),cell.end()-1);
+  for(size_t i=0; i<points.size(); ++i)
+    sorted[at[cellOf[i]]++] = points[i];
+  points = std::move(sorted);
+  }
+
+int32_t WayMatrix::PointGrid::cellX(float x) const {
+  return std::clamp(int32_t((x-x0)/cellSz),0,w-1);
+  }
+
+int32_t WayMatrix::PointGrid::cellZ(float z) const {
+  return std::clamp(int32_t((z-z0)/cellSz),0,h-1);
+  }
+
+template<class F>
+void WayMatrix::PointGrid::foreach(const Vec3& at, float R, const F& func) const {
+  if(points.empty())
+    return;
+  const int32_t bx = cellX(at.x-R), ex = cellX(at.x+R);
+  const int32_t bz = cellZ(at.z-R), ez = cellZ(at.z+R);
+  const float   R2 = R*R;
+  for(int32_t iz=bz; iz<=ez; ++iz) {
+    for(int32_t ix=bx; ix<=ex; ++ix) {
+      const size_t c = size_t(iz*w+ix);
+      for(uint32_t i=cell[c]; i<cell[c+1]; ++i) {
+        auto& wp = *points[i];
+        if((wp.position()-at).quadLength()<=R2)
+          func(wp);
+        }
+      }
+    }
+  }
+
+template<class F>
+const WayPoint* WayMatrix::PointGrid::nearest(const Vec3& at, float R, const F& filter) const {
+  if(points.empty())
+    return nullptr;
+
+  struct Candidate {
+    float           dist = 0;
+    const WayPoint* wp   = nullptr;
+    };
+  std::vector<Candidate> cand;
+
+  const float   R2   = (R<std::numeric_limits<float>::max() ? R*R : R);
+  const int32_t cx   = cellX(at.x);
+  const int32_t cz   = cellZ(at.z);
+  const int32_t maxK = std::max(w,h);
+
+  // expanding rings of cells; candidates are tested in distance order, so that
+  // expensive filters (ray-casts) run for as few points as possible
+  for(int32_t k=0; k<=maxK; ++k) {
+    for(int32_t iz=cz-k; iz<=cz+k; ++iz) {
+      if(iz<0 || iz>=h)
+        continue;
+      const bool edge = (iz==cz-k || iz==cz+k);
+      for(int32_t ix=cx-k; ix<=cx+k; ix += (edge ? 1 : 2*k)) {
+        if(0<=ix && ix<w) {
+          const size_t c = size_t(iz*w+ix);
+          for(uint32_t i=cell[c]; i<cell[c+1]; ++i) {
+            float l = (points[i]->position()-at).quadLength();
+            if(l<=R2)
+              cand.push_back({l,points[i]});
+            }
+          }
+        if(k==0)
+          break;
+        }
+      }
 
-  stk[0].reserve(256);
-  stk[1].reserve(256);
+    // all points closer than 'bound' are collected at this point
+    const float ring  = float(k)*cellSz;
+    const bool  last  = (k==maxK || ring>=R);
+    const float bound = last ? std::numeric_limits<float>::max() : ring*ring;
+
+    std::sort(cand.begin(),cand.end(),[](const Candidate& a, const Candidate& b){
+      return a.dist>b.dist;
+      });
+    while(!cand.empty() && cand.back().dist<=bound) {
+      auto wp = cand.back().wp;
+      cand.pop_back();
+      if(filter(*wp))
+        return wp;
+      }
+    if(last)
+      break;
+    }
+  return nullptr;
   }
 
 void WayMatrix::buildIndex() {
@@ -47,11 +171,14 @@ void WayMatrix::buildIndex() {
     return a->name<b->name;
     });
 
-  for(auto& i:freePoints)
-    fpInd.push_back(&i);
-  std::sort(fpInd.begin(),fpInd.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  std::vector<const WayPoint*> pt;
+  pt.reserve(wayPoints.size());
+  for(auto& i:wayPoints)
+    pt.push_back(&i);
+  wpGrid.build(std::move(pt));
+  allGrid.build(std::vector<const WayPoint*>(indexPoints.begin(),indexPoints.end()));
+  fpIndex.clear();
+  clearRoutes();
 
   for(auto& i:edges){
     if(i.a<wayPoints.size() && i.b<wayPoints.size()){
@@ -65,43 +192,23 @@ void WayMatrix::buildIndex() {
   }
 
 const WayPoint *WayMatrix::findWayPoint(const Vec3& at, const std::function<bool(const WayPoint&)>& filter) const {
-  const WayPoint* ret =nullptr;
-  float           dist=std::numeric_limits<float>::max();
-  for(auto& w:wayPoints) {
-    if(!filter(w))
-      continue;
-    auto  dp0 = at-w.position();
-    float l0  = dp0.quadLength();
+  return wpGrid.nearest(at,std::numeric_limits<float>::max(),filter);
+  }
 
-    if(l0<dist){
-      ret  = &w;
-      dist = l0;
-      }
-    }
-  return ret;
+void WayMatrix::detectWayPoint(const Vec3& at, float R, const std::function<void(const WayPoint&)>& func) const {
+  wpGrid.foreach(at,R,func);
   }
 
 const WayPoint *WayMatrix::findFreePoint(const Vec3& at, std::string_view name, const std::function<bool(const WayPoint&)>& filter) const {
   auto&  index = findFpIndex(name);
-  return findFreePoint(at.x,at.y,at.z,index,filter);
+  return findFreePoint(at,index,filter);
   }
 
 const WayPoint *WayMatrix::findNextPoint(const Vec3& at) const {
-  const WayPoint* ret   = nullptr;
-  float           dist  = distanceThreshold;
-
-  dist*=dist;
-  for(auto pw:indexPoints){
-    auto& w  = *pw;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-
-    if(l<dist && dp.z*dp.z<300*300 && !w.isLocked()){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+  return allGrid.nearest(at,distanceThreshold,[&at](const WayPoint& w){
+    auto dp = w.position()-at;
+    return dp.z*dp.z<300*300 && !w.isLocked();
+    });
   }
 
 void WayMatrix::addFreePoint(const Vec3& pos, const Vec3& dir, std::string_view name) {
@@ -177,9 +284,15 @@ void WayMatrix::marchPoints(DbgPainter &p) const {
   }
 
 void WayMatrix::adjustWaypoints(std::vector<WayPoint> &wp) {
-  for(auto& w:wp) {
-    w.y = world.physic()->landRay(w.position()).v.y;
-    indexPoints.push_back(&w);
+  std::vector<Tempest::Vec3>               pos(wp.size());
+  std::vector<DynamicWorld::RayLandResult> lnd(wp.size());
+  for(size_t i=0; i<wp.size(); ++i)
+    pos[i] = wp[i].position();
+  world.physic()->landRay(pos.data(),lnd.data(),wp.size());
+
+  for(size_t i=0; i<wp.size(); ++i) {
+    wp[i].y = lnd[i].v.y;
+    indexPoints.push_back(&wp[i]);
     }
   }
 
@@ -193,55 +306,35 @@ const WayMatrix::FpIndex &WayMatrix::findFpIndex(std::string_view name) const {
 
   FpIndex id;
   id.key = name;
+
+  std::vector<const WayPoint*> pt;
   for(auto& w:freePoints){
     if(!w.checkName(name))
       continue;
-    id.index.push_back(&w);
+    pt.push_back(&w);
     }
-  // TODO: good index, not sort by 'x' :)
-  std::sort(id.index.begin(),id.index.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  id.index.build(std::move(pt));
 
   it = fpIndex.insert(it,std::move(id));
   return *it;
   }
 
-const WayPoint *WayMatrix::findFreePoint(float x, float y, float z, const FpIndex& ind,
+const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const FpIndex& ind,
                                          const std::function<bool(const WayPoint&)>& filter) const {
-  float R = distanceThreshold;
-  auto b = std::lower_bound(ind.index.begin(),ind.index.end(), x-R ,[](const WayPoint *a, float b){
-    return a->x<b;
-    });
-  auto e = std::upper_bound(ind.index.begin(),ind.index.end(), x+R ,[](float a,const WayPoint *b){
-    return a<b->x;
+  return ind.index.nearest(at,distanceThreshold,[&at,&filter](const WayPoint& w){
+    float dz = w.z-at.z;
+    if(dz*dz>300*300)
+      return false;
+    return filter(w);
     });
-
-  const WayPoint* ret=nullptr;
-  auto  count = std::distance(b,e);(void) count;
-  float dist  = R*R;
-  for(auto i=b;i!=e;++i){
-    auto& w  = **i;
-    float dx = w.x-x;
-    float dy = w.y-y;
-    float dz = w.z-z;
-    float l  = dx*dx+dy*dy+dz*dz;
-    if(l>dist || dz*dz>300*300)
-      continue;
-    if(!filter(w))
-      continue;
-    ret  = &w;
-    dist = l;
-    }
-  return ret;
   }
 
 WayPath WayMatrix::wayTo(const WayPoint** begin, size_t beginSz, const Tempest::Vec3 exactBegin, const WayPoint& end) const {
   if(beginSz==0)
     return WayPath();
 
-  intptr_t endId = std::distance<const WayPoint*>(&wayPoints[0],&end);
-  if(endId<0 || size_t(endId)>=wayPoints.size()){
+  const uint32_t endId = pointId(end);
+  if(endId==NoPoint) {
     if(end.name.find("FP_")==0) {
       WayPath ret;
       ret.add(end);
@@ -250,75 +343,153 @@ WayPath WayMatrix::wayTo(const WayPoint** begin, size_t beginSz, const Tempest::
     return WayPath();
     }
 
-  pathGen++;
-  if(pathGen==1){
-    // new cycle
-    for(auto& i:wayPoints)
-      i.pathGen=0;
-    }
+  std::vector<uint32_t> route;
+  if(beginSz==1 && findRoute(pointId(*begin[0]),endId,route))
+    return mkPath(route);
 
-  std::vector<const WayPoint*> *front=&stk[0], *back=&stk[1];
-  stk[0].clear();
-  stk[1].clear();
+  auto ctx   = acquirePathCtx();
+  bool found = findPath(*ctx,begin,beginSz,exactBegin,endId,route);
+  releasePathCtx(std::move(ctx));
+  if(!found)
+    return WayPath();
 
-  end.pathLen = 0;
-  end.pathGen = pathGen;
-  front->push_back(&end);
+  // route from the best begin-point is optimal regardless of other begin-points
+  storeRoute(route.front(),endId,route);
+  return mkPath(route);
+  }
 
-  while(front->size()>0) {
-    bool done = true;
-    for(size_t i=0; i<beginSz; ++i)
-      if(begin[i]->pathGen!=pathGen) {
-        done = false;
-        break;
-        }
-    if(done)
-      break;
+uint32_t WayMatrix::pointId(const WayPoint& wp) const {
+  if(wayPoints.empty())
+    return NoPoint;
+  intptr_t id = std::distance<const WayPoint*>(&wayPoints[0],&wp);
+  if(id<0 || size_t(id)>=wayPoints.size())
+    return NoPoint;
+  return uint32_t(id);
+  }
+
+void WayMatrix::PathCtx::reset(size_t size) {
+  if(gen.size()!=size) {
+    len   .assign(size,0);
+    parent.assign(size,NoPoint);
+    gen   .assign(size,0);
+    curGen = 0;
+    }
+  curGen++;
+  if(curGen==0) {
+    // new cycle
+    std::fill(gen.begin(),gen.end(),0);
+    curGen = 1;
+    }
+  heap.clear();
+  }
 
-    for(auto& wp:*front) {
-      int32_t l0 = wp->pathLen;
+bool WayMatrix::findPath(PathCtx& ctx, const WayPoint** begin, size_t beginSz, const Vec3& exactBegin,
+                         uint32_t endId, std::vector<uint32_t>& route) const {
+  // A* from 'end' towards 'exactBegin'; begin-points are linked to virtual goal-node
+  const uint32_t goal = uint32_t(wayPoints.size());
+  ctx.reset(wayPoints.size()+1);
+
+  auto heuristic = [&](uint32_t id) {
+    if(id==goal)
+      return 0;
+    // edge length is rounded down - scale estimation to keep it admissible
+    return int32_t((wayPoints[id].position()-exactBegin).length()*0.95f);
+    };
+  auto cmp = [](const PathCtx::Node& l, const PathCtx::Node& r) {
+    return l.f>r.f;
+    };
+  auto relax = [&](uint32_t id, int32_t g, uint32_t from) {
+    if(ctx.isVisited(id) && ctx.len[id]<=g)
+      return;
+    ctx.gen   [id] = ctx.curGen;
+    ctx.len   [id] = g;
+    ctx.parent[id] = from;
+    ctx.heap.push_back({g+heuristic(id),g,id});
+    std::push_heap(ctx.heap.begin(),ctx.heap.end(),cmp);
+    };
+
+  relax(endId,0,NoPoint);
+  while(!ctx.heap.empty()) {
+    std::pop_heap(ctx.heap.begin(),ctx.heap.end(),cmp);
+    const auto n = ctx.heap.back();
+    ctx.heap.pop_back();
+
+    if(n.id==goal)
+      break;
+    if(n.g>ctx.len[n.id])
+      continue;
 
-      for(auto i:wp->connections()){
-        auto& w  = *i.point;
-        int32_t l1 = l0+i.len;
-        if(w.pathGen!=pathGen || w.pathLen>l1){
-          w.pathLen = l1;
-          w.pathGen = pathGen;
-          back->push_back(&w);
-          }
+    auto& wp = wayPoints[n.id];
+    for(size_t i=0; i<beginSz; ++i) {
+      if(begin[i]==&wp) {
+        relax(goal, n.g+int32_t((exactBegin-wp.position()).length()), n.id);
+        break;
         }
       }
-    std::swap(front,back);
-    back->clear();
+    for(auto& i:wp.connections())
+      relax(pointId(*i.point), n.g+i.len, n.id);
     }
 
-  const WayPoint* first = begin[0];
-  for(size_t i=0; i<beginSz; ++i) {
-    int32_t iLen = begin[i]->pathLen + int((exactBegin - begin[i]->position()).length());
-    int32_t fLen = first   ->pathLen + int((exactBegin - first   ->position()).length());
-    if(iLen<fLen)
-      first = begin[i];
-    }
+  if(!ctx.isVisited(goal))
+    return false;
 
+  route.clear();
+  for(uint32_t id=ctx.parent[goal]; id!=NoPoint; id=ctx.parent[id])
+    route.push_back(id);
+  return true;
+  }
+
+WayPath WayMatrix::mkPath(const std::vector<uint32_t>& route) const {
   WayPath ret;
-  ret.add(*first);
-  const WayPoint* current = first;
-  while(current!=&end) {
-    int32_t l0 = current->pathLen, l1=l0;
-
-    const WayPoint* next=nullptr;
-    for(auto i:current->connections()){
-      if(i.point->pathGen==pathGen && i.point->pathLen+i.len<=l0 && i.point->pathLen<l1){
-        next = i.point;
-        l1   = i.point->pathLen;
-        }
-      }
-    if(next==nullptr)
-      return WayPath();
-    ret.add(*next);
-    current=next;
-    }
+  for(size_t i=route.size(); i>0; --i)
+    ret.add(wayPoints[route[i-1]]);
+  return ret;
+  }
 
-  ret.reverse();
+std::unique_ptr<WayMatrix::PathCtx> WayMatrix::acquirePathCtx() const {
+  std::lock_guard<std::mutex> guard(pathSync);
+  if(pathCtx.empty())
+    return std::make_unique<PathCtx>();
+  auto ret = std::move(pathCtx.back());
+  pathCtx.pop_back();
   return ret;
   }
+
+void WayMatrix::releasePathCtx(std::unique_ptr<PathCtx> ctx) const {
+  std::lock_guard<std::mutex> guard(pathSync);
+  pathCtx.push_back(std::move(ctx));
+  }
+
+bool WayMatrix::findRoute(uint32_t begin, uint32_t end, std::vector<uint32_t>& route) const {
+  if(begin==NoPoint)
+    return false;
+  const uint64_t key = (uint64_t(begin) << 32) | end;
+
+  std::lock_guard<std::mutex> guard(pathSync);
+  auto it = routeIndex.find(key);
+  if(it==routeIndex.end())
+    return false;
+  routeLru.splice(routeLru.begin(),routeLru,it->second);
+  route = it->second->points;
+  return true;
+  }
+
+void WayMatrix::storeRoute(uint32_t begin, uint32_t end, const std::vector<uint32_t>& route) const {
+  const uint64_t key = (uint64_t(begin) << 32) | end;
+
+  std::lock_guard<std::mutex> guard(pathSync);
+  if(routeIndex.find(key)!=routeIndex.end())
+    return;
+  if(routeLru.size()>=RouteCacheMax) {
+    routeIndex.erase(routeLru.back().key);
+    routeLru.pop_back();
+    }
+  routeLru.push_front(Route{key,route});
+  routeIndex[key] = routeLru.begin();
+  }
+
+void WayMatrix::clearRoutes() {
+  std::lock_guard<std::mutex> guard(pathSync);
+  routeLru.clear();
+  routeIndex.clear();
+  }
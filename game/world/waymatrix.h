@@ -6,6 +6,10 @@
 #include <phoenix/world/way_net.hh>
 
 #include <vector>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
 #include <functional>
 
 #include "waypath.h"
@@ -19,6 +23,7 @@ class WayMatrix final {
     WayMatrix(World& owner,const phoenix::way_net& dat);
 
     const WayPoint* findWayPoint (const Tempest::Vec3& at, const std::function<bool(const WayPoint&)>& filter) const;
+    void            detectWayPoint(const Tempest::Vec3& at, float R, const std::function<void(const WayPoint&)>& func) const;
     const WayPoint* findFreePoint(const Tempest::Vec3& at, std::string_view name, const std::function<bool(const WayPoint&)>& filter) const;
     const WayPoint* findNextPoint(const Tempest::Vec3& at) const;
 
@@ -32,6 +37,7 @@ class WayMatrix final {
     const WayPoint* findPoint(std::string_view name, bool inexact) const;
     void            marchPoints(DbgPainter& p) const;
 
+    // thread-safe: search state lives in per-query context
     WayPath         wayTo(const WayPoint** begin, size_t beginSz, const Tempest::Vec3 exactBegin, const WayPoint& end) const;
 
   private:
@@ -44,20 +50,78 @@ class WayMatrix final {
     std::vector<WayPoint>  freePoints, startPoints;
     std::vector<WayPoint*> indexPoints;
 
-    std::vector<WayPoint*> fpInd;
+    // uniform grid in XZ plane
+    struct PointGrid {
+      void build(std::vector<const WayPoint*> points);
+
+      template<class F>
+      void foreach(const Tempest::Vec3& at, float R, const F& func) const;
+      template<class F>
+      const WayPoint* nearest(const Tempest::Vec3& at, float R, const F& filter) const;
+
+      private:
+        float                        cellSz = 0;
+        float                        x0 = 0, z0 = 0;
+        int32_t                      w  = 0, h  = 0;
+        std::vector<uint32_t>        cell;
+        std::vector<const WayPoint*> points;
+
+        int32_t cellX(float x) const;
+        int32_t cellZ(float z) const;
+      };
+    PointGrid              wpGrid, allGrid;
 
     struct FpIndex {
       std::string                  key;
-      std::vector<const WayPoint*> index;
+      PointGrid                    index;
       };
     mutable std::vector<FpIndex>          fpIndex;
 
-    mutable uint16_t                      pathGen=0;
-    mutable std::vector<const WayPoint*>  stk[2];
+    enum : uint32_t {
+      NoPoint       = uint32_t(-1),
+      RouteCacheMax = 512,
+      };
+
+    struct PathCtx {
+      struct Node {
+        int32_t  f  = 0;
+        int32_t  g  = 0;
+        uint32_t id = 0;
+        };
+      std::vector<int32_t>  len;
+      std::vector<uint32_t> parent;
+      std::vector<uint16_t> gen;
+      uint16_t              curGen = 0;
+      std::vector<Node>     heap;
+
+      void reset(size_t size);
+      bool isVisited(uint32_t id) const { return gen[id]==curGen; }
+      };
+
+    struct Route {
+      uint64_t              key = 0;
+      std::vector<uint32_t> points;
+      };
+
+    mutable std::mutex                            pathSync;
+    mutable std::vector<std::unique_ptr<PathCtx>> pathCtx;
+    mutable std::list<Route>                      routeLru;
+    mutable std::unordered_map<uint64_t,std::list<Route>::iterator> routeIndex;
 
     void                   adjustWaypoints(std::vector<WayPoint> &wp);
+    uint32_t               pointId(const WayPoint& wp) const;
+
+    bool                   findPath(PathCtx& ctx, const WayPoint** begin, size_t beginSz, const Tempest::Vec3& exactBegin,
+                                    uint32_t endId, std::vector<uint32_t>& route) const;
+    WayPath                mkPath(const std::vector<uint32_t>& route) const;
+
+    std::unique_ptr<PathCtx> acquirePathCtx() const;
+    void                     releasePathCtx(std::unique_ptr<PathCtx> ctx) const;
+    bool                     findRoute(uint32_t begin, uint32_t end, std::vector<uint32_t>& route) const;
+    void                     storeRoute(uint32_t begin, uint32_t end, const std::vector<uint32_t>& route) const;
+    void                     clearRoutes();
 
     const FpIndex&         findFpIndex(std::string_view name) const;
-    const WayPoint*        findFreePoint(float x, float y, float z, const FpIndex &ind,
+    const WayPoint*        findFreePoint(const Tempest::Vec3& at, const FpIndex &ind,
                                          const std::function<bool(const WayPoint&)>& filter) const;
   };
@@ -3,6 +3,7 @@
 #include <fstream>
 #include <functional>
 #include <cctype>
+#include <exception>
 
 #include <Tempest/Log>
 #include <Tempest/Painter>
@@ -16,6 +17,7 @@
 #include "game/globaleffects.h"
 #include "game/serialize.h"
 #include "utils/string_frm.h"
+#include "utils/workers.h"
 #include "gothic.h"
 #include "focus.h"
 #include "resources.h"
@@ -76,26 +78,33 @@ World::World(GameSession& game, std::string_view file, bool startup, std::functi
                                                                 : phoenix::game_version::gothic_2);
     loadProgress(20);
 
+    // landscape, physics and waynet do not depend on each other
     auto& worldMesh = world.world_mesh;
     {
-      PackedMesh vmesh(worldMesh,PackedMesh::PK_VisualLnd);
-      wview.reset   (new WorldView(*this,vmesh));
+      Workers::TaskGroup ld;
+      ld.run([&]() {
+        PackedMesh vmesh(worldMesh,PackedMesh::PK_VisualLnd,wname);
+        wview.reset(new WorldView(*this,vmesh));
+        });
+      ld.run([&]() {
+        wdynamic.reset(new DynamicWorld(*this,worldMesh));
+        });
+      ld.run([&]() {
+        wmatrix.reset(new WayMatrix(*this,world.world_way_net));
+        });
+      ld.wait();
     }
-
-    loadProgress(50);
-    wdynamic.reset(new DynamicWorld(*this,worldMesh));
     loadProgress(70);
 
     globFx.reset(new GlobalEffects(*this));
 
-    wmatrix.reset(new WayMatrix(*this,world.world_way_net));
-
     for(auto& vob:world.world_vobs)
       wobj.addRoot(vob,startup);
 
     wmatrix->buildIndex();
     bsp = std::move(world.world_bsp_tree);
     bspSectors.resize(bsp.sectors.size());
+    buildBspIndex();
     loadProgress(100);
     }
   catch(...) {
@@ -278,63 +287,80 @@ Npc *World::findNpcByInstance(size_t instance) {
   }
 
 std::string_view World::roomAt(const Tempest::Vec3& p) {
-  if(bsp.nodes.empty())
+  const uint32_t id = roomIdAt(p);
+  if(id==NoRoom)
     return "";
+  return bsp.sectors[id].name;
+  }
 
-  const auto* node=&bsp.nodes[0];
+uint32_t World::roomIdAt(const Tempest::Vec3& p) const {
+  if(bsp.nodes.empty())
+    return NoRoom;
 
+  uint32_t id = 0;
   while(true) {
-    const auto v    = node->plane;
-    float        sgn  = v.x*p.x + v.y*p.y + v.z*p.z - v.w;
-    uint32_t     next = (sgn>0) ? uint32_t(node->front_index) : uint32_t(node->back_index);
+    const auto v    = bsp.nodes[id].plane;
+    float      sgn  = v.x*p.x + v.y*p.y + v.z*p.z - v.w;
+    uint32_t   next = (sgn>0) ? uint32_t(bsp.nodes[id].front_index) : uint32_t(bsp.nodes[id].back_index);
     if(next>=bsp.nodes.size())
       break;
-
-    node = &bsp.nodes[next];
+    id = next;
     }
 
-  if(node->bbox.min.x <= p.x && p.x <node->bbox.max.x &&
-     node->bbox.min.y <= p.y && p.y <node->bbox.max.y &&
-     node->bbox.min.z <= p.z && p.z <node->bbox.max.z) {
-    return roomAt(*node);
+  auto& node = bsp.nodes[id];
+  if(node.bbox.min.x <= p.x && p.x <node.bbox.max.x &&
+     node.bbox.min.y <= p.y && p.y <node.bbox.max.y &&
+     node.bbox.min.z <= p.z && p.z <node.bbox.max.z) {
+    return bspLeafRoom[id];
     }
 
-  return "";
+  return NoRoom;
   }
 
 std::string_view World::roomAt(const phoenix::bsp_node& node) {
-  const std::string* ret=nullptr;
-  size_t       count=0;
-  auto         id = &node-bsp.nodes.data();(void)id;
-
-  for(auto& i:bsp.sectors) {
-    for(auto r:i.node_indices)
-      if(r<bsp.leaf_node_indices.size()){
-        size_t idx = bsp.leaf_node_indices[r];
-        if(idx>=bsp.nodes.size())
-          continue;
-        if(&bsp.nodes[idx]==&node) {
-          ret = &i.name;
-          count++;
-          }
-        }
-    }
-  if(count==1) {
-    // TODO: portals
-    return *ret;
+  const size_t id = size_t(&node-bsp.nodes.data());
+  if(id>=bspLeafRoom.size() || bspLeafRoom[id]==NoRoom) {
+    static std::string empty;
+    return empty;
     }
-  static std::string empty;
-  return empty;
+  return bsp.sectors[bspLeafRoom[id]].name;
   }
 
 World::BspSector* World::portalAt(std::string_view tag) {
   if(tag.empty())
     return nullptr;
 
-  for(size_t i=0;i<bsp.sectors.size();++i)
-    if(bsp.sectors[i].name==tag)
-      return &bspSectors[i];
-  return nullptr;
+  auto it = bspRoomId.find(tag);
+  if(it==bspRoomId.end())
+    return nullptr;
+  return &bspSectors[it->second];
+  }
+
+void World::buildBspIndex() {
+  // first sector wins on duplicated names, same as linear search did
+  bspRoomId.clear();
+  bspRoomId.reserve(bsp.sectors.size());
+  for(size_t i=0; i<bsp.sectors.size(); ++i)
+    bspRoomId.emplace(bsp.sectors[i].name,uint32_t(i));
+
+  // leaf, that is referenced by more than one sector has no room
+  std::vector<uint32_t> count(bsp.nodes.size(),0);
+  bspLeafRoom.assign(bsp.nodes.size(),NoRoom);
+  for(size_t i=0; i<bsp.sectors.size(); ++i) {
+    for(auto r:bsp.sectors[i].node_indices) {
+      if(r>=bsp.leaf_node_indices.size())
+        continue;
+      size_t idx = bsp.leaf_node_indices[r];
+      if(idx>=bsp.nodes.size())
+        continue;
+      // canonical id, so equal names compare equal
+      bspLeafRoom[idx] = bspRoomId[bsp.sectors[i].name];
+      count[idx]++;
+      }
+    }
+  for(size_t i=0; i<count.size(); ++i)
+    if(count[i]!=1)
+      bspLeafRoom[i] = NoRoom;
   }
 
 void World::scaleTime(uint64_t& dt) {
@@ -740,6 +766,18 @@ void World::invalidateVobIndex() {
   wobj.invalidateVobIndex();
   }
 
+void World::updateVobIndex(Item& it) {
+  wobj.updateVobIndex(it);
+  }
+
+void World::updateVobIndex(Interactive& it) {
+  wobj.updateVobIndex(it);
+  }
+
+void World::updateNpcIndex(Npc& npc) {
+  wobj.updateNpcIndex(npc);
+  }
+
 const phoenix::c_focus& World::searchPolicy(const Npc& pl, TargetCollect& coll, WorldObjects::SearchFlg& opt) const {
   opt  = WorldObjects::NoFlg;
   coll = TARGET_COLLECT_FOCUS;
@@ -785,6 +823,10 @@ const WayPoint* World::findWayPoint(const Tempest::Vec3& pos, const std::functio
   return wmatrix->findWayPoint(pos,f);
   }
 
+void World::detectWayPoint(const Tempest::Vec3& pos, const float r, const std::function<void(const WayPoint&)>& f) const {
+  wmatrix->detectWayPoint(pos,r,f);
+  }
+
 const WayPoint *World::findFreePoint(const Npc &npc, std::string_view name) const {
   if(auto p = npc.currentWayPoint()){
     if(p->isFreePoint() && p->checkName(name)) {
@@ -918,11 +960,7 @@ int32_t World::guildOfRoom(std::string_view portalName) {
     return -1;
 
   auto name = portalName.substr(b,e-b);
-
-  for(size_t i=0;i<bsp.sectors.size();++i) {
-    auto& s = bsp.sectors[i].name;
-    if(s==name)
-      return bspSectors[i].guild;
-    }
+  if(auto room=portalAt(name))
+    return room->guild;
   return GIL_NONE;
   }
@@ -4,6 +4,7 @@
 #include <Tempest/IndexBuffer>
 #include <Tempest/Matrix4x4>
 #include <string>
+#include <unordered_map>
 #include <functional>
 
 #include <phoenix/world.hh>
@@ -39,6 +40,10 @@ class World final {
       int32_t guild=GIL_NONE;
       };
 
+    enum : uint32_t {
+      NoRoom = uint32_t(-1),
+      };
+
     void                 createPlayer(std::string_view cls);
     void                 insertPlayer(std::unique_ptr<Npc>&& npc, std::string_view waypoint);
     void                 setPlayer(Npc* npc);
@@ -61,6 +66,7 @@ class World final {
     const WayPoint*      findPoint(std::string_view name, bool inexact=true) const;
     const WayPoint*      findWayPoint(const Tempest::Vec3& pos) const;
     const WayPoint*      findWayPoint(const Tempest::Vec3& pos, const std::function<bool(const WayPoint&)>& f) const;
+    void                 detectWayPoint(const Tempest::Vec3& pos, const float r, const std::function<void(const WayPoint&)>& f) const;
 
     const WayPoint*      findFreePoint(const Npc& pos,           std::string_view name) const;
     const WayPoint*      findFreePoint(const Tempest::Vec3& pos, std::string_view name) const;
@@ -103,12 +109,14 @@ class World final {
     MeshObjects::Mesh    addDecalView (const phoenix::vob& vob);
 
     void                 updateAnimation(uint64_t dt);
+    auto                 animLodStat() const -> Pose::LodStat { return wobj.animLodStat(); }
     void                 resetPositionToTA();
 
     auto                 takeHero() -> std::unique_ptr<Npc>;
     Npc*                 player() const { return npcPlayer; }
     Npc*                 findNpcByInstance(size_t instance);
     std::string_view     roomAt(const Tempest::Vec3& arr);
+    uint32_t             roomIdAt(const Tempest::Vec3& arr) const;
 
     void                 scaleTime(uint64_t& dt);
     void                 tick(uint64_t dt);
@@ -175,6 +183,9 @@ class World final {
     void                 addSound      (const phoenix::vob& vob);
 
     void                 invalidateVobIndex();
+    void                 updateVobIndex(Item& it);
+    void                 updateVobIndex(Interactive& it);
+    void                 updateNpcIndex(Npc& npc);
 
   private:
     const phoenix::c_focus&     searchPolicy(const Npc& pl, TargetCollect& coll, WorldObjects::SearchFlg& opt) const;
@@ -184,6 +195,8 @@ class World final {
     std::unique_ptr<WayMatrix>            wmatrix;
     phoenix::bsp_tree                     bsp;
     std::vector<BspSector>                bspSectors;
+    std::vector<uint32_t>                 bspLeafRoom; // bsp node -> sector id, or NoRoom
+    std::unordered_map<std::string_view,uint32_t> bspRoomId;
 
     Npc*                                  npcPlayer=nullptr;
 
@@ -196,6 +209,7 @@ class World final {
 
     auto         roomAt(const phoenix::bsp_node &node) -> std::string_view;
     auto         portalAt(std::string_view tag) -> BspSector*;
+    void         buildBspIndex();
 
     void         initScripts(bool firstTime);
 
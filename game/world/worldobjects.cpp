@@ -108,6 +108,12 @@ void WorldObjects::load(Serialize &fin) {
     i->postValidate();
   for(auto& i:npcArr)
     i->postValidate();
+
+  npcIndex.clear();
+  npcNear.clear();
+  npcActive.clear();
+  for(size_t i=0; i<npcArr.size(); ++i)
+    indexNpc(i);
   }
 
 void WorldObjects::save(Serialize &fout) {
@@ -157,6 +163,8 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
     std::sort(npcArr.begin(),npcArr.end(),[](std::unique_ptr<Npc>& a, std::unique_ptr<Npc>& b){
       return a->handle().id<b->handle().id;
       });
+    for(size_t i=0; i<npcArr.size(); ++i)
+      npcIndex.move(npcArr[i].get(),i);
     }
 
   for(size_t i=0; i<npcArr.size(); ++i) {
@@ -202,41 +210,74 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   npcNear.clear();
   const int   PERC_DIST_INTERMEDIAT = 1000;
   const float nearDist              = 3000*3000;
-  const float farDist               = 6000*6000;
+  const float farRange              = 6000;
+  const float farDist               = farRange*farRange;
 
   auto plPos = pl->position();
-  for(auto& i:npcArr) {
-    float dist = (i->position()-plPos).quadLength();
+  // only npc's in range, or leaving the range, need to be classified
+  for(auto i:npcActive) {
+    if((i->position()-plPos).quadLength()>=farDist)
+      i->setProcessPolicy(Npc::ProcessPolicy::AiFar2);
+    }
+  npcActive.clear();
+  npcIndex.find(plPos,farRange,[&](Npc& i) {
+    float dist = (i.position()-plPos).quadLength();
     if(dist<nearDist){
-      npcNear.push_back(i.get());
-      if(i.get()!=pl)
-        i->setProcessPolicy(Npc::ProcessPolicy::AiNormal);
+      npcNear.push_back(&i);
+      if(&i!=pl)
+        i.setProcessPolicy(Npc::ProcessPolicy::AiNormal);
       } else
     if(dist<farDist) {
-      i->setProcessPolicy(Npc::ProcessPolicy::AiFar);
+      i.setProcessPolicy(Npc::ProcessPolicy::AiFar);
       } else {
-      i->setProcessPolicy(Npc::ProcessPolicy::AiFar2);
+      return;
       }
-    }
+    npcActive.push_back(&i);
+    });
+  // keep npcArr order, as full scan did
+  std::sort(npcNear.begin(),npcNear.end(),[this](const Npc* a, const Npc* b){
+    return npcIndex.order(a)<npcIndex.order(b);
+    });
   tickNear(dt);
   for(CollisionZone* z:collisionZn)
     z->tick(dt);
   tickTriggers(dt);
 
+  // fan-out of passive perception: npc -> messages in range, in order of sending
+  struct PercHit {
+    Npc*   npc = nullptr;
+    size_t msg = 0;
+    };
+  std::vector<PercHit> percHit;
+  for(size_t k=0; k<passive.size(); ++k) {
+    auto& r = passive[k];
+    if(r.other==nullptr || r.victum==nullptr)
+      continue;
+    npcIndex.find(r.pos,float(PERC_DIST_INTERMEDIAT),[&](Npc& i) {
+      if(&i!=r.self)
+        percHit.push_back({&i,k});
+      });
+    }
+  std::sort(percHit.begin(),percHit.end(),[](const PercHit& a, const PercHit& b){
+    return std::tie(a.npc,a.msg)<std::tie(b.npc,b.msg);
+    });
+
   for(auto& ptr:npcNear) {
     Npc& i = *ptr;
     if(i.isPlayer() || i.isDead())
       continue;
 
     if(i.processPolicy()==Npc::AiNormal) {
-      for(auto& r:passive) {
-        if(r.self==&i)
-          continue;
+      auto hit = std::lower_bound(percHit.begin(),percHit.end(),&i,[](const PercHit& h, const Npc* npc){
+        return h.npc<npc;
+        });
+      for(; hit!=percHit.end() && hit->npc==&i; ++hit) {
+        auto& r = passive[hit->msg];
         float l = i.qDistTo(r.pos.x,r.pos.y,r.pos.z);
-        if(r.item!=size_t(-1) && r.other!=nullptr)
-          owner.script().setInstanceItem(*r.other,r.item);
         const float range = float(std::min(i.handle().senses_range,PERC_DIST_INTERMEDIAT));
-        if(l<range*range && r.other!=nullptr && r.victum!=nullptr) {
+        if(l<range*range) {
+          if(r.item!=size_t(-1))
+            owner.script().setInstanceItem(*r.other,r.item);
           // aproximation of behavior of original G2
           if(!i.isDown() && !i.isPlayer() && i.isAiQueueEmpty() &&
              i.canSenseNpc(*r.other, true)!=SensesBit::SENSE_NONE &&
@@ -311,6 +352,7 @@ Npc* WorldObjects::addNpc(size_t npcInstance, std::string_view at) {
     npc->attachToPoint(pos);
     npc->updateTransform();
     npcArr.emplace_back(npc);
+    indexNpc(npcArr.size()-1);
     } else {
     auto& point = owner.deadPoint();
     npc->attachToPoint(nullptr);
@@ -329,6 +371,7 @@ Npc* WorldObjects::addNpc(size_t npcInstance, const Vec3& pos) {
   npc->updateTransform();
 
   npcArr.emplace_back(npc);
+  indexNpc(npcArr.size()-1);
   return npc;
   }
 
@@ -351,6 +394,7 @@ Npc* WorldObjects::insertPlayer(std::unique_ptr<Npc> &&npc, std::string_view at)
     npc->updateTransform();
     }
   npcArr.emplace_back(std::move(npc));
+  indexNpc(npcArr.size()-1);
   return npcArr.back().get();
   }
 
@@ -361,12 +405,27 @@ std::unique_ptr<Npc> WorldObjects::takeNpc(const Npc* ptr) {
       auto ret=std::move(npcArr[i]);
       npcArr[i] = std::move(npcArr.back());
       npcArr.pop_back();
+      unindexNpc(ret.get());
+      if(i<npcArr.size())
+        npcIndex.move(npcArr[i].get(),i);
       return ret;
       }
     }
   return nullptr;
   }
 
+void WorldObjects::indexNpc(size_t id) {
+  Npc* npc = npcArr[id].get();
+  npcIndex.add(npc,id);
+  // new npc has to be classified by next tick
+  npcActive.push_back(npc);
+  }
+
+void WorldObjects::unindexNpc(Npc* npc) {
+  npcIndex.del(npc);
+  npcActive.erase(std::remove(npcActive.begin(),npcActive.end(),npc),npcActive.end());
+  }
+
 void WorldObjects::tickNear(uint64_t /*dt*/) {
   for(Npc* i:npcNear) {
     auto pos = i->position() + Vec3(0,i->translateY(),0);
@@ -410,12 +469,20 @@ void WorldObjects::updateAnimation(uint64_t dt) {
   static bool doAnim=true;
   if(!doAnim)
     return;
-  Workers::parallelTasks(npcArr,[dt](std::unique_ptr<Npc>& i){
-    i->updateAnimation(dt);
+  Pose::resetLodStat();
+  Workers::TaskGroup anim;
+  anim.run([this,dt](){
+    Workers::parallelTasks(npcArr,[dt](std::unique_ptr<Npc>& i){
+      i->updateAnimation(dt);
+      });
     });
-  interactiveObj.parallelFor([dt](Interactive& i){
-    i.updateAnimation(dt);
+  anim.run([this,dt](){
+    interactiveObj.parallelFor([dt](Interactive& i){
+      i.updateAnimation(dt);
+      });
     });
+  anim.wait();
+  animLod = Pose::lodStat();
   }
 
 bool WorldObjects::isTargeted(Npc& dst) {
@@ -459,12 +526,13 @@ void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
 
 void WorldObjects::detectNpc(const float x, const float y, const float z,
                              const float r, const std::function<void(Npc&)>& f) {
+  const Vec3 p = {x,y,z};
   float maxDist=r*r;
-  for(auto& i:npcArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
+  npcIndex.find(p,r,[&](Npc& i) {
+    auto qDist = (i.position()-p).quadLength();
     if(qDist<maxDist)
-      f(*i);
-    }
+      f(i);
+    });
   }
 
 void WorldObjects::detectItem(const float x, const float y, const float z,
@@ -667,6 +735,18 @@ void WorldObjects::invalidateVobIndex() {
   interactiveObj.invalidate();
   }
 
+void WorldObjects::updateVobIndex(Item& it) {
+  items.move(&it);
+  }
+
+void WorldObjects::updateVobIndex(Interactive& it) {
+  interactiveObj.move(&it);
+  }
+
+void WorldObjects::updateNpcIndex(Npc& npc) {
+  npcIndex.move(&npc);
+  }
+
 Interactive* WorldObjects::validateInteractive(Interactive *def) {
   return interactiveObj.hasObject(def) ? def : nullptr;
   }
@@ -842,15 +922,19 @@ void WorldObjects::resetPositionToTA() {
   for(auto& r:routines)
     r.curState = 0;
 
-  for(auto& i:npcInvalid)
+  for(auto& i:npcInvalid) {
     npcArr.push_back(std::move(i));
+    indexNpc(npcArr.size()-1);
+    }
   npcInvalid.clear();
 
   for(size_t i=0;i<npcArr.size();) {
     auto& n = *npcArr[i];
     if(n.resetPositionToTA()){
+      npcIndex.move(&n,i);
       ++i;
       } else {
+      unindexNpc(&n);
       npcInvalid.emplace_back(std::move(npcArr[i]));
       npcArr.erase(npcArr.begin()+int(i));
 
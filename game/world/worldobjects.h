@@ -7,9 +7,11 @@
 
 #include "bullet.h"
 #include "spaceindex.h"
+#include "npcindex.h"
 #include "game/gametime.h"
 #include "game/perceptionmsg.h"
 #include "game/constants.h"
+#include "graphics/mesh/pose.h"
 
 class Npc;
 class Item;
@@ -56,6 +58,7 @@ class WorldObjects final {
     auto           takeNpc(const Npc* npc) -> std::unique_ptr<Npc>;
 
     void           updateAnimation(uint64_t dt);
+    auto           animLodStat() const -> Pose::LodStat { return animLod; }
 
     bool           isTargeted(Npc& npc);
     Npc*           findHero();
@@ -101,10 +104,16 @@ class WorldObjects final {
 
     Bullet&        shootBullet(const Item &itmId, const Tempest::Vec3& pos, const Tempest::Vec3& dir, float tgRange, float speed);
 
+    void           indexNpc  (size_t id);
+    void           unindexNpc(Npc* npc);
+
     void           addInteractive(Interactive*         obj);
     void           addStatic     (StaticObj*           obj);
     void           addRoot       (const std::unique_ptr<phoenix::vob>& vob, bool startup);
     void           invalidateVobIndex();
+    void           updateVobIndex(Item& it);
+    void           updateVobIndex(Interactive& it);
+    void           updateNpcIndex(Npc& npc);
 
     Interactive*   validateInteractive(Interactive *def);
     Npc*           validateNpc        (Npc         *def);
@@ -163,6 +172,9 @@ class WorldObjects final {
     std::vector<std::unique_ptr<Npc>>  npcArr;
     std::vector<std::unique_ptr<Npc>>  npcInvalid;
     std::vector<Npc*>                  npcNear;
+    std::vector<Npc*>                  npcActive;
+    NpcIndex                           npcIndex;
+    Pose::LodStat                      animLod;
 
     std::vector<AbstractTrigger*>      triggers;
     std::vector<AbstractTrigger*>      triggersZn;
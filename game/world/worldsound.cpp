@@ -266,39 +266,56 @@ void WorldSound::tickSlot(std::vector<PEffect>& effect) {
       ++i;
       }
     }
+
+  // occlusion rays are resolved in one batch
+  std::vector<DynamicWorld::RaySegment> rays;
+  std::vector<Effect*>                  slots;
   for(auto& i:effect) {
-    tickSlot(*i);
+    auto& slot = *i;
+    if(!prepareSlot(slot))
+      continue;
+    rays .push_back({plPos,slot.pos});
+    slots.push_back(&slot);
     }
+
+  std::vector<float> occ(rays.size());
+  owner.physic()->soundOclusion(rays.data(),occ.data(),rays.size());
+  for(size_t i=0; i<slots.size(); ++i)
+    applyOcclusion(*slots[i],occ[i]);
   }
 
 void WorldSound::tickSlot(Effect& slot) {
+  if(!prepareSlot(slot))
+    return;
+  applyOcclusion(slot,owner.physic()->soundOclusion(plPos,slot.pos));
+  }
+
+bool WorldSound::prepareSlot(Effect& slot) {
+  // restarts looped sound; returns true, if occlusion ray has to be traced
   if(slot.eff.isFinished()) {
     if(!slot.loop)
-      return;
+      return false;
     slot.eff.play();
     }
-
   if(slot.ambient) {
     slot.setOcclusion(1.f);
-    } else {
-    auto  dyn  = owner.physic();
-    auto  head = plPos;
-    auto  pos  = slot.pos;
-    float occ  = 1;
-
-    if((pos-head).quadLength()<slot.maxDist*slot.maxDist)
-      occ = dyn->soundOclusion(head, pos);
-    slot.setOcclusion(std::max(0.f,1.f-occ));
+    return false;
+    }
+  if((slot.pos-plPos).quadLength()>=slot.maxDist*slot.maxDist) {
+    slot.setOcclusion(0.f);
+    return false;
     }
+  return true;
   }
 
-void WorldSound::initSlot(WorldSound::Effect& slot) {
-  auto  dyn = owner.physic();
-  auto  pos = slot.pos;
-  float occ = dyn->soundOclusion(plPos, pos);
+void WorldSound::applyOcclusion(Effect& slot, float occ) {
   slot.setOcclusion(std::max(0.f,1.f-occ));
   }
 
+void WorldSound::initSlot(WorldSound::Effect& slot) {
+  applyOcclusion(slot,owner.physic()->soundOclusion(plPos,slot.pos));
+  }
+
 bool WorldSound::setMusic(std::string_view zone, GameMusic::Tags tags) {
   bool             isDay = (tags&GameMusic::Ngt)==0;
   std::string_view smode = "STD";
@@ -60,6 +60,8 @@ class WorldSound final {
     void    tickSoundZone(Npc& player);
     void    tickSlot(std::vector<PEffect>& eff);
     void    tickSlot(Effect& slot);
+    bool    prepareSlot(Effect& slot);
+    void    applyOcclusion(Effect& slot, float occ);
     void    initSlot(Effect& slot);
     bool    setMusic(std::string_view zone, GameMusic::Tags tags);
 